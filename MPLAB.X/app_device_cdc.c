@@ -28,20 +28,28 @@ limitations under the License.
 #include "app_device_cdc.h"
 #include "usb_config.h"
 #include "uart.h"
+#include "stats.h"
+#include "stream.h"
+#include "direct.h"
 
 /** VARIABLES ******************************************************/
 
-//static bool buttonPressed;
-//static char buttonMessage[] = "Button pressed.\r\n";
-static uint8_t USB_Out_Buffer[CDC_DATA_OUT_EP_SIZE];
-static uint8_t RS232_Out_Data[CDC_DATA_IN_EP_SIZE];
+//UART -> USB: the data is read straight into the CDC IN endpoint buffer, free
+//whenever USBUSARTIsTxTrfReady() (see USBUSARTTxBuffer())
+#define USB_Out_Buffer USBUSARTTxBuffer()
+//USB -> UART: the data is sent from the CDC OUT endpoint buffer, released
+//once sent (see peekUSBUSART())
+#define RS232_Out_Data USBUSARTRxBuffer()
 
-unsigned char  NextUSBOut;
-unsigned char    NextUSBOut;
-unsigned char    LastRS232Out;  // Number of characters in the buffer
-unsigned char    RS232cp;       // current position within the buffer
-unsigned char RS232_Out_Data_Rdy = 0;
+#if defined(CDC_PROG_BAUDRATE) && (STREAM_HEAD + STREAM_MAX_DATA + 2 > UART_RX_SIZE)
+#error "the stream frame does not fit in the UART ring buffer"
+#endif
+
+unsigned char    NextUSBOut;    // Number of characters in USB_Out_Buffer
+unsigned char    LastRS232Out;  // Number of characters in RS232_Out_Data, 0 = released
 USB_HANDLE  lastTransmission;
+static uint8_t   pendingSince;  // 1ms tick when the oldest waiting byte arrived
+static bool      streaming;     // binary programming protocol selected
 
 
 /******************************************************************************
@@ -81,6 +89,22 @@ void APP_SetLineCodingHandler(void)
 
         //Update the baudrate of the UART
         UART_baudrateSet(line_coding.dwDTERate);
+
+    #if defined(CDC_PROG_BAUDRATE)
+        //The programming rate selects the binary protocol, from its first
+        //frame.  The UART receiver is stopped meanwhile, the parser assembles
+        //the frames in its ring buffer.
+        if(line_coding.dwDTERate == CDC_PROG_BAUDRATE)
+        {
+            STREAM_Initialize(UART_RxStop());
+            streaming = true;
+        }
+        else if(streaming)
+        {
+            streaming = false;
+            UART_RxStart();
+        }
+    #endif
     //}        
 }
 #endif
@@ -107,24 +131,15 @@ void APP_DeviceCDCEmulatorInitialize()
     line_coding.bParityType = 0;
     line_coding.dwDTERate = 19200;
 
-    unsigned char i;
     UART_Initialize();
 
-// 	 Initialize the arrays
-	for (i=0; i<sizeof(USB_Out_Buffer); i++)
-    {
-		USB_Out_Buffer[i] = 0;
-    }
-
 	NextUSBOut = 0;
 	LastRS232Out = 0;
 	lastTransmission = 0;
+	pendingSince = (uint8_t)USBGet1msTickCount();
+	streaming = false;
 }
 
-
-    #define mDataRdyUSART() PIR1bits.RCIF
-    #define mTxRdyUSART()   TXSTAbits.TRMT
-
 /*********************************************************************
 * Function: void APP_DeviceCDCEmulatorTasks(void);
 *
@@ -141,56 +156,68 @@ void APP_DeviceCDCEmulatorInitialize()
 ********************************************************************/
 void APP_DeviceCDCEmulatorTasks()
 {
-    
+    uint8_t pending, now;
+
     if((USBDeviceState < CONFIGURED_STATE)||(USBSuspendControl==1)) return;
 
-	if (RS232_Out_Data_Rdy == 0)  // only check for new USB buffer if the old RS232 buffer is
-	{						  // empty.  This will cause additional USB packets to be NAK'd
-		LastRS232Out = getsUSBUSART(RS232_Out_Data,64); //until the buffer is free.
-		if(LastRS232Out > 0)
-		{
-			RS232_Out_Data_Rdy = 1;  // signal buffer full
-			RS232cp = 0;  // Reset the current position
-		}
-	}
+    //The OUT packet sent to the UART is released once transmitted
+    if((LastRS232Out > 0) && (UART_TxBusy() == false))
+    {
+        releaseUSBUSART();
+        LastRS232Out = 0;
+    }
 
-    //Check if one or more bytes are waiting in the physical UART transmit
-    //queue.  If so, send it out the UART TX pin.
-	if(RS232_Out_Data_Rdy && mTxRdyUSART())
+    #if defined(CDC_PROG_BAUDRATE)
+    //Binary programming protocol: the OUT packets are parsed as frames (and
+    //programmed) instead of being sent to the UART, the IN endpoint carries
+    //the acknowledgements.  A packet is read only when the previous one has
+    //been processed and the target is ready for it, the host is NAK'd while
+    //a row is being programmed or the previous image verified.
+    if(streaming)
+    {
+        if((LastRS232Out == 0) && DIRECT_WriteReady())
+        {
+            NextUSBOut = peekUSBUSART();
+            if(NextUSBOut > 0)
+            {
+                STREAM_Parse(RS232_Out_Data, NextUSBOut);
+                releaseUSBUSART();
+            }
+        }
+        if(USBUSARTIsTxTrfReady())
+        {
+            NextUSBOut = STREAM_Reply(USB_Out_Buffer);
+            if(NextUSBOut > 0)
+            {
+                putUSBUSART(&USB_Out_Buffer[0], NextUSBOut);
+            }
+        }
+        CDCTxService();
+        return;
+    }
+    #endif
+
+    //The UART is fed by its interrupt handler, a whole packet at a time: only
+    //check for a new USB packet once the previous one has been sent.  This
+    //will cause additional USB packets to be NAK'd until the buffer is free.
+	if (LastRS232Out == 0)
 	{
     	#if defined(USB_CDC_SUPPORT_HARDWARE_FLOW_CONTROL)
         	//Make sure the receiving UART device is ready to receive data before
         	//actually sending it.
         	if(UART_CTS == USB_CDC_CTS_ACTIVE_LEVEL)
-        	{
-        		USART_putcUSART(RS232_Out_Data[RS232cp]);
-        		++RS232cp;
-        		if (RS232cp == LastRS232Out)
-        			RS232_Out_Data_Rdy = 0;
-    	    }
-	    #else
-	        //Hardware flow control not being used.  Just send the data.
-    		UART_putch(RS232_Out_Data[RS232cp]);
-    		++RS232cp;
-    		if (RS232cp == LastRS232Out)
-    			RS232_Out_Data_Rdy = 0;
-	    #endif
-	}
-
-    //Check if we received a character over the physical UART, and we need
-    //to buffer it up for eventual transmission to the USB host.
-	if(mDataRdyUSART() && (NextUSBOut < (CDC_DATA_OUT_EP_SIZE - 1)))
+    	#endif
         {
-		USB_Out_Buffer[NextUSBOut] = UART_getch();
-		++NextUSBOut;
-		USB_Out_Buffer[NextUSBOut] = 0;
+            LastRS232Out = peekUSBUSART();
+            UART_Write(RS232_Out_Data, LastRS232Out);
+        }
 	}
 
 	#if defined(USB_CDC_SUPPORT_HARDWARE_FLOW_CONTROL)
     	//Drive RTS pin, to let UART device attached know if it is allowed to
     	//send more data or not.  If the receive buffer is almost full, we
     	//deassert RTS.
-    	if(NextUSBOut <= (CDC_DATA_OUT_EP_SIZE - 5u))
+    	if(UART_RxCount() <= (UART_RX_SIZE - 8u))
     	{
             UART_RTS = USB_CDC_RTS_ACTIVE_LEVEL;
         }
@@ -200,13 +227,27 @@ void APP_DeviceCDCEmulatorTasks()
         }
     #endif
 
-    //Check if any bytes are waiting in the queue to send to the USB host.
-    //If any bytes are waiting, and the endpoint is available, prepare to
-    //send the USB packet to the host.
-	if((USBUSARTIsTxTrfReady()) && (NextUSBOut > 0))
+    //Check if any bytes are waiting in the receive ring buffer to send to the 
+    //USB host. Bytes are aggregated into full packets, a partial packet is
+    //sent only once its oldest byte has waited CDC_IN_FLUSH_MS.
+	if(USBUSARTIsTxTrfReady())
 	{
-		putUSBUSART(&USB_Out_Buffer[0], NextUSBOut);
-		NextUSBOut = 0;
+		now = (uint8_t)USBGet1msTickCount();
+		pending = UART_RxCount();
+		if(pending == 0)
+		{
+			pendingSince = now;
+		}
+		else if((pending >= CDC_DATA_IN_EP_SIZE) ||
+		        ((uint8_t)(now - pendingSince) >= CDC_IN_FLUSH_MS))
+		{
+			NextUSBOut = UART_Read(USB_Out_Buffer, CDC_DATA_IN_EP_SIZE);
+			putUSBUSART(&USB_Out_Buffer[0], NextUSBOut);
+			pendingSince = now;     // the remaining bytes arrived meanwhile
+			stats.cdc_packets++;
+			stats.cdc_bytes += NextUSBOut;
+			if(NextUSBOut == CDC_DATA_IN_EP_SIZE) stats.cdc_full++;
+		}
 	}
 
     CDCTxService();
@@ -34,7 +34,7 @@ limitations under the License.
 //  In this example the media initialization function is named
 //  "MediaInitialize", the read capacity function is named "ReadCapacity",
 //  etc.
-LUN_FUNCTIONS LUN[MAX_LUN + 1] =
+const LUN_FUNCTIONS LUN[MAX_LUN + 1] =     // const: kept in program memory
 {
     {
         (FILEIO_MEDIA_INFORMATION* (*)(void *))&DIRECT_MediaInitialize,
@@ -106,4 +106,7 @@ void APP_DeviceMSDInitialize()
 void APP_DeviceMSDTasks()
 {
     MSDTasks();
+    if (MSD_State == MSD_WAIT) {    // between commands
+        DIRECT_Tasks();
+    }
 }
@@ -0,0 +1,77 @@
+/*******************************************************************************
+Copyright 2016 Microchip Technology Inc. (www.microchip.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*******************************************************************************/
+
+#ifndef DEVICE_H
+#define	DEVICE_H
+
+#include "system.h"     // DIRECT_USE_ICSP
+
+/*******************************************************************************
+ Device profiles, selected at compile time
+
+ Loader device (self-programming, memory.c): chosen by the compiler --chip
+ option. The loader occupies the flash below DEVICE_APP_FLASH, the --rom
+ range of the project must end at DEVICE_APP_FLASH - 1.
+
+ Target device (DIRECT_USE_ICSP): chosen with -DTARGET_PIC16F188xx,
+ PIC16F18855 by default.
+
+ See the 'matrix' target in the Makefile to build every profile.
+
+ UF2 blocks carrying a family ID (flag 0x2000) are only programmed if it is
+ the ID of the device profile. No family ID is registered for these parts in
+ the UF2 list (github.com/microsoft/uf2), the values are made of part numbers.
+ ******************************************************************************/
+
+#if defined(_16F1454) || defined(_16LF1454) || defined(_16F1455) || defined(_16LF1455) || \
+    defined(_16F1459) || defined(_16LF1459)
+    #define DEVICE_WRITE_SIZE   32          // words per write latch block
+    #define DEVICE_ERASE_SIZE   32          // words per erase row
+    #define DEVICE_END_FLASH    0x2000
+    #define DEVICE_UF2_FAMILY   0x16F14500UL    // PIC16(L)F145x
+#else
+    #error "Unsupported loader device, add its profile to device.h"
+#endif
+
+#define DEVICE_APP_FLASH        0x1600      // start of the application (end of the loader)
+
+// rows are formed and programmed one erase row at a time
+#define DEVICE_ROW_SIZE         DEVICE_ERASE_SIZE
+
+#if (DEVICE_ERASE_SIZE % DEVICE_WRITE_SIZE) || (DEVICE_APP_FLASH % DEVICE_ERASE_SIZE)
+    #error "The erase row must be a multiple of the write block, and the application row aligned"
+#endif
+
+#if defined(DIRECT_USE_ICSP)
+    #if defined(TARGET_PIC16F18854)
+        #define TARGET_END_FLASH    0x1000
+    #elif defined(TARGET_PIC16F18856) || defined(TARGET_PIC16F18876)
+        #define TARGET_END_FLASH    0x4000
+    #elif defined(TARGET_PIC16F18857) || defined(TARGET_PIC16F18877)
+        #define TARGET_END_FLASH    0x8000
+    #else   // PIC16F18855, PIC16F18875
+        #define TARGET_END_FLASH    0x2000
+    #endif
+    // common to all the PIC16F188xx
+    #define TARGET_ROW_SIZE         32
+    #define TARGET_CFG_ADDRESS      0x8000  // row containing the config words
+    #define TARGET_CFG_OFFSET       7       // first config word (0x8007) within its row
+    #define TARGET_CFG_NUM          5
+    #define TARGET_UF2_FAMILY       0x16F18800UL    // PIC16F188xx
+#endif
+
+#endif	/* DEVICE_H */
@@ -24,6 +24,12 @@ limitations under the License.
 #include "files.h"
 #include "memory.h"
 #include "pwm2.h"
+#include "usb.h"
+#include "stats.h"
+#include "system.h"
+#if defined(DIRECT_USE_ICSP)
+#include "icsp.h"
+#endif
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -31,7 +37,23 @@ limitations under the License.
  * Global Variables
  *****************************************************************************/
 static FILEIO_MEDIA_INFORMATION mediaInformation;
-bool ParseHex(char c);
+bool ParseHex(uint8_t *buffer, uint8_t count);
+static uint8_t hexSectorStart( uint16_t sector, uint8_t *buffer);
+static void hexSectorEnd( void);
+static void hexReset( void);
+static void hexTimeout( void);
+static void binWrite( uint16_t offset, uint8_t *buffer);
+#if !defined(DIRECT_USE_ICSP)
+static void programStep( void);
+#endif
+static uint16_t bin_offset = ROOT_NOT_BIN;  // offset of the current sector in the *.BIN image
+static uint16_t unrouted;                   // first cluster dropped since the root update, 0 = none
+static bool hexText( uint8_t *buffer);
+static bool hex_text;                       // the current sector can be Intel HEX text
+static bool other;                          // the current sector belongs to an other file
+static bool uf2Start( uint8_t *buffer);
+static void uf2Write( uint8_t *buffer, uint8_t seg);
+static bool uf2;                            // the current sector is a UF2 block
 
 /******************************************************************************
  * Function:        uint8_t MediaDetect(void* config)
@@ -117,11 +139,21 @@ uint8_t DIRECT_SectorRead(void* config, uint32_t sector_addr, uint8_t* buffer, u
     else {
         memset(buffer, '\0', MSD_IN_EP_SIZE); // empty buffer
         if ( 4 == sector_addr) {        // Service README.HTM
-            if ( seg < ( (readme_size() + 63) % 64) ) 
+            if ( seg < ( (readme_size() + 63) / 64) ) 
                 strncpy( (void*)buffer, 
                          (void*)&readme[seg*64], 
                          64);  // at most 64 bytes at a time
         }
+        else if ( sector_addr == STATUS_CLUSTER + 2) {
+            StatusGet( buffer, seg);
+        }
+        else if ( sector_addr == STATS_CLUSTER + 2) {
+            StatsGet( buffer, seg);
+        }
+        else if (( sector_addr >= CURRENT_HEX_CLUSTER + 2) &&
+                 ( sector_addr < CURRENT_HEX_CLUSTER + 2 + CURRENT_HEX_SECTORS)) {
+            CurrentHexGet( buffer, (uint16_t)sector_addr - (CURRENT_HEX_CLUSTER + 2), seg);
+        }
     }
 	return true;
 }//end SectorRead
@@ -135,6 +167,8 @@ uint8_t DIRECT_SectorRead(void* config, uint32_t sector_addr, uint8_t* buffer, u
  *****************************************************************************/
 uint8_t DIRECT_SectorWrite(void* config, uint32_t sector_addr, uint8_t* buffer, uint8_t seg)
 {
+    uint8_t skip;
+
     if (( sector_addr < 2) ||(sector_addr >= DRV_FILEIO_INTERNAL_FLASH_TOTAL_DISK_SIZE))
     {
         return false;
@@ -145,12 +179,45 @@ uint8_t DIRECT_SectorWrite(void* config, uint32_t sector_addr, uint8_t* buffer,
     }
     if ( 3 == sector_addr) {            // update of the root directory
         RootRecordSet( buffer, seg);
+        if ( seg == 7) {                // data dropped before the entry was known (Linux)
+            if (( unrouted != 0) && ( RootBinOffset( unrouted) != ROOT_NOT_BIN))
+                direct_stats.result = DIRECT_RESULT_ORDER;
+            unrouted = 0;
+        }
         return true;
     }
 
+    if ( seg == 0) {                    // UF2 blocks are recognized wherever they land
+        uf2 = uf2Start( buffer);
+    }
+    if ( uf2) {
+        uf2Write( buffer, seg);
+        return true;
+    }
+    if ( seg == 0) {                    // other files are discarded
+        other = RootClusterIgnore( (uint16_t)sector_addr - 2);
+    }
+    if ( other) {
+        return true;
+    }
+    if ( seg == 0) {
+        bin_offset = RootBinOffset( (uint16_t)sector_addr - 2);
+        hex_text = (bin_offset == ROOT_NOT_BIN) && hexText( buffer);
+    }
+    if ( bin_offset != ROOT_NOT_BIN) {  // raw binary images are programmed as they are
+        binWrite( bin_offset + (uint16_t)seg * MSD_OUT_EP_SIZE, buffer);
+        return true;
+    }
+    if ( !hex_text) {                   // e.g. *.BIN data written before its directory entry
+        if (( seg == 0) && ( unrouted == 0)) unrouted = (uint16_t)sector_addr - 2;
+        return true;
+    }
     // all remaining data sectors are parsed and programmed directly into the device
-    uint16_t i=0;
-    while( (i++ < 64) && ParseHex(*buffer++));
+    skip = (seg == 0) ? hexSectorStart( (uint16_t)sector_addr, buffer) : 0;
+    if ( !ParseHex( &buffer[ skip], MSD_OUT_EP_SIZE - skip)) {
+        stats.parse_errors++;
+    }
+    if (seg == 7) hexSectorEnd();
     
     return true;
 } // SectorWrite
@@ -170,26 +237,71 @@ uint8_t DIRECT_WriteProtectStateGet(void* config)
  This is a simple state machine that parses an input stream to detect and decode
  the INTEL Hex file format produced by the MPLAB XC8 compiler
  Bytes are assembled in Words 
- Words are assembled in Rows (currently supporting fixed size of 32-words)
+ Words are assembled in Rows (size from the device profile, see device.h),
+ a small cache of Rows lets records revisit a Row before it is programmed
  Rows are aligned (normalized) and written directly to the target using LVP ICSP
+ (DIRECT_USE_ICSP) or self-programmed into the application area
  Special treatment is reserved for words written to 'configuration' addresses 
  ******************************************************************************/
-#define ROW_SIZE     32      // for all pic16f188xx
-#define CFG_ADDRESS 0x8000   // for all pic16f188xx
-#define CFG_NUM      5       // number of config words for PIC16F188xx
+#if defined(DIRECT_USE_ICSP)
+#define ROW_SIZE     TARGET_ROW_SIZE
+#define CFG_ADDRESS  TARGET_CFG_ADDRESS
+#define CFG_NUM      TARGET_CFG_NUM
+#define CFG_OFFSET   TARGET_CFG_OFFSET
+#else
+#define ROW_SIZE     DEVICE_ROW_SIZE
+#define CFG_ADDRESS  0x8000  // configuration space, never self-programmed
+#endif
+#if (ROW_SIZE & (ROW_SIZE - 1))
+    #error "The row size must be a power of 2"
+#endif
+
+#define WORD_MASK   0x3fff   // flash words are 14-bit wide
+#define APP_ROWS    ((END_FLASH - APP_FLASH) / ROW_SIZE)
+
+#define ROW_CACHE   1            // rows being formed at the same time (2*ROW_SIZE bytes each),
+                                 // revisited rows are still merged, re-read from flash
+#define ROW_NONE    0xffffffffUL // free cache entry
 
 // internal state
-uint16_t row[ ROW_SIZE];    // buffer containing row being formed
-uint32_t row_address;       // destination address of current row 
+static uint16_t row[ ROW_CACHE][ ROW_SIZE]; // buffers containing rows being formed
+static uint32_t row_address[ ROW_CACHE];    // destination address of each row
+static uint8_t  row_age[ ROW_CACHE];        // 0 = most recently used
 bool     lvp;               // flag: low voltage programming in progress
 
+DIRECT_STATS direct_stats;  // programming counters
+
+static uint16_t start_ms;                          // USB tick at the start of the sequence
+static uint16_t uf2_blocks;                        // UF2 blocks received of the current file
+#if defined(DIRECT_USE_ICSP)                       // the whole flash in 256 byte payloads
+#define UF2_MAX_BLOCKS  ((uint16_t)(TARGET_END_FLASH / 128) + 8)
+#else
+#define UF2_MAX_BLOCKS  ((END_FLASH / 128) + 8)
+#endif
+static uint8_t  uf2_received[ (UF2_MAX_BLOCKS + 7) / 8]; // one bit per block number
+static bool     verify_pending;                    // end of sequence, rows left to erase then verify
+#if !defined(DIRECT_USE_ICSP)
+static uint8_t  row_written[ (APP_ROWS + 7) / 8];  // rows passed to flash in this sequence
+static uint8_t  erase_next;                        // next row to consider for pre-erase
+static bool     erase_armed;                       // a row needed an erase, pre-erase the others
+static uint8_t  verify_next;                       // next row to re-read for the verification
+static bool     verify_lost;                       // data was dropped in the sequence pending
+#endif
+#define BIN_SECTORS     (((END_FLASH - APP_FLASH) * 2 + 511) / 512)
+static uint8_t  bin_received[ (BIN_SECTORS + 7) / 8]; // *.BIN sectors received in this sequence
+static bool     data_lost;                         // part of the image was dropped, cannot pass
+
 /** 
  * State machine initialization
  */
 void DIRECT_Initialize( void) {
-    memset((void*)row, 0xff, sizeof(row));    // fill buffer with blanks
-    row_address = 0x8000;
+    memset((void*)row, 0xff, sizeof(row));    // fill buffers with blanks
+    memset((void*)row_address, 0xff, sizeof(row_address));  // all free (ROW_NONE)
     lvp = false;
+    memset((void*)&direct_stats, 0, sizeof(direct_stats));
+    hexReset();
+    uf2_blocks = 0;
+    memset((void*)uf2_received, 0, sizeof(uf2_received));
 }
 
 /**
@@ -197,44 +309,386 @@ void DIRECT_Initialize( void) {
  * @return  true if lvp sequence in progress
  */
 bool DIRECT_ProgrammingInProgress( void) {
-    return lvp;
+#if defined(DIRECT_USE_ICSP)
+    return lvp || ICSP_Busy();
+#else
+    return lvp || verify_pending;
+#endif
+}
+
+/**
+ * Test if the next data packet can be processed without waiting for the target
+ * Polled by the MSD data OUT phase (MSD_WRITE_READY) and by the CDC streaming
+ * protocol before they take a packet, the host is NAKed meanwhile. 
+ * @return  true if a row can be passed to the target at once
+ */
+bool DIRECT_WriteReady( void) {
+#if defined(DIRECT_USE_ICSP)
+    return !lvp || ICSP_Ready();
+#else
+    // the end of the previous sequence first, one step per poll
+    if (verify_pending) programStep();
+    return !verify_pending;
+#endif
+}
+
+/**
+ * Update a CRC-16 (CCITT, polynomial 0x1021) with a flash word, low byte first
+ */
+static uint16_t crcWord( uint16_t crc, uint16_t word)
+{
+    uint8_t i;
+
+    crc ^= word << 8;                   // low byte
+    for( i=0; i < 8; i++) 
+        crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    crc ^= word & 0xff00;               // high byte
+    for( i=0; i < 8; i++) 
+        crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    return crc;
 }
 
-bool isDigit( char * c){
-    if (*c < '0') return false;
-    *c -= '0'; if (*c > 9) *c-=7;
-    if (*c > 0xf)  return false;
+/**
+ * Read an application word, the integrity record reads as blank
+ */
+static uint16_t appRead( uint16_t address)
+{
+    return (address < APP_CRC) ? FLASH_ReadWord( address) : WORD_MASK;
+}
+
+/**
+ * CRC-16 of an application row as currently found in flash
+ * seeded with the row address so that the row sums depend on the placement,
+ * a blank row counts 0 so that the sum does not depend on the rows left blank
+ */
+static uint16_t crcFlashRow( uint16_t address)
+{
+    uint8_t  i;
+    uint16_t word;
+    uint16_t crc = address;
+    bool     blank = true;
+
+    for( i=0; i < ROW_SIZE; i++) {
+        word = appRead( address + i);
+        if (word != WORD_MASK) blank = false;
+        crc = crcWord( crc, word);
+    }
+    return blank ? 0 : crc;
+}
+
+#if !defined(DIRECT_USE_ICSP)
+/**
+ * Clear the commit marker, before the application is modified
+ * Programmed without erasing: the blank words of the row buffer leave the
+ * other words of the block unchanged.
+ */
+static void appInvalidate( void)
+{
+    uint16_t *words = row[ 0];      // blank and free between two sequences
+
+    if (FLASH_ReadWord( APP_MARKER) != APP_COMMITTED) return;   // already invalid
+    words[ APP_MARKER & (WRITE_FLASH_BLOCKSIZE - 1)] = 0;
+    FLASH_ProgramBlock( APP_MARKER & ~(WRITE_FLASH_BLOCKSIZE - 1), words);
+    words[ APP_MARKER & (WRITE_FLASH_BLOCKSIZE - 1)] = 0xffff;
+}
+
+/**
+ * Write the integrity record of a verified image: the last application row
+ * is rewritten with the CRC and, last, the commit marker
+ */
+static void appCommit( uint16_t crc)
+{
+    uint16_t *words = row[ 0];      // blank and free once the rows are written
+    uint16_t address = END_FLASH - ROW_SIZE;
+    uint8_t  i;
+    uint16_t start;
+
+    for( i=0; i < ROW_SIZE; i++) words[ i] = appRead( address + i);
+    words[ APP_CRC - address] = crc & 0xff;
+    words[ APP_CRC + 1 - address] = crc >> 8;
+    words[ APP_MARKER - address] = APP_COMMITTED;
+    start = STATS_TIME();
+    FLASH_EraseBlock( address);
+    for( i=0; i< ROW_SIZE; i+= WRITE_FLASH_BLOCKSIZE) 
+        FLASH_ProgramBlock( address + i, &words[i]);
+    STATS_ELAPSED( stats.flash_ticks, start);
+    memset((void*)words, 0xff, sizeof(row[ 0]));
+}
+#endif
+
+/**
+ * Check the integrity record of the application, from the fast boot
+ * Only the commit marker is read, a constant cost whatever the image size,
+ * unless SYSTEM_BOOT_CRC_CHECK also sums the CRC of the rows again.
+ * @return  true if the application can be started
+ */
+bool DIRECT_AppValid( void) {
+#if defined(DIRECT_USE_ICSP)
+    // the local application is not programmed by the loader
+    return (FLASH_ReadWord( APP_FLASH) != WORD_MASK);
+#else
+  #if defined(SYSTEM_BOOT_CRC_CHECK)
+    uint8_t  i;
+    uint16_t crc = 0;
+  #endif
+
+    if (FLASH_ReadWord( APP_MARKER) != APP_COMMITTED) return false;
+  #if defined(SYSTEM_BOOT_CRC_CHECK)
+    for( i=0; i < APP_ROWS; i++) 
+        crc += crcFlashRow( APP_FLASH + (uint16_t)i * ROW_SIZE);
+    return (crc == (FLASH_ReadWord( APP_CRC) | (FLASH_ReadWord( APP_CRC + 1) << 8)));
+  #else
     return true;
+  #endif
+#endif
 }
-    
-void lvpWrite( void){
+
+#if !defined(DIRECT_USE_ICSP)
+/**
+ * Pre-erase the next application row, unless already blank or already passed 
+ * to flash in this sequence
+ * Called from the idle loop, one row at a time, so that the rows are ready to 
+ * be programmed without an erase (and its stall) by the time the data arrives.
+ * Only once a row of the image has needed an erase (erase_armed): an image 
+ * copied again is then left to be skipped row by row, and an image that only
+ * clears bits is programmed without erasing.
+ */
+static void rowErase( void)
+{
+    uint8_t  i = erase_next++;
+    uint8_t  j;
+    uint16_t start;
+    uint16_t address = APP_FLASH + (uint16_t)i * ROW_SIZE;
+
+    if (row_written[ i >> 3] & (1 << (i & 7))) return;
+    for( j=0; j < ROW_SIZE; j++) {      // blank check, the integrity record is rewritten by appCommit
+        if (appRead( address + j) != WORD_MASK) break;
+    }
+    if (j == ROW_SIZE) return;
+    start = STATS_TIME();
+    FLASH_EraseBlock( address);
+    STATS_ELAPSED( stats.flash_ticks, start);
+    direct_stats.rows_erased++;
+}
+
+/**
+ * Conclude the verification of the programming sequence
+ * The CRC of the rows written, re-read from flash, must match the sum 
+ * accumulated as the rows were passed to flash (in whichever order), and no
+ * data must have been dropped on the way.
+ */
+static void programVerify( void)
+{
+    direct_stats.result = (!verify_lost && (direct_stats.flash_crc == direct_stats.image_crc)) ? 
+            DIRECT_RESULT_PASS : DIRECT_RESULT_FAIL;
+    if (direct_stats.result == DIRECT_RESULT_PASS) appCommit( direct_stats.image_crc);
+    direct_stats.time_ms = (uint16_t)USBGet1msTickCount() - start_ms;
+}
+
+/**
+ * Advance the sequence left pending by programLastRow by one row
+ * The rows not in the image are erased (those not reached before the end), 
+ * then the rows written are re-read one at a time, and the image is verified
+ * and committed. Each call is bounded by a row erase, or the commit.
+ */
+static void programStep( void)
+{
+    uint8_t i;
+
+    if (erase_next < APP_ROWS) {
+        rowErase();
+        return;
+    }
+    if (verify_next < APP_ROWS) {
+        i = verify_next++;
+        if (row_written[ i >> 3] & (1 << (i & 7))) 
+            direct_stats.flash_crc += crcFlashRow( APP_FLASH + (uint16_t)i * ROW_SIZE);
+        return;
+    }
+    programVerify();
+    verify_pending = false;
+}
+#endif
+
+/**
+ * Begin a new programming sequence on the first data received
+ */
+static void programStart( void)
+{
+    if (lvp) return;
+    // a sequence starting in the packet that ended the previous one supersedes
+    // it, before its verification: that image is not committed
+    verify_pending = false;
+    lvp = true;
+    direct_stats.data_bytes = 0;
+    direct_stats.rows_written = 0;
+    direct_stats.image_crc = 0;
+    direct_stats.flash_crc = 0;
+    direct_stats.result = DIRECT_RESULT_NONE;
+    memset( (void*)bin_received, 0, sizeof( bin_received));
+    start_ms = (uint16_t)USBGet1msTickCount();
+#if defined(DIRECT_USE_ICSP)
+    ICSP_Enter();
+#else
+    memset( (void*)row_written, 0, sizeof( row_written));
+    erase_next = 0;
+    erase_armed = false;
+    appInvalidate();
+#endif
+}
+
+/**
+ * Background tasks, to be called while the USB interface is idle
+ */
+void DIRECT_Tasks( void) {
+#if defined(DIRECT_USE_ICSP)
+    ICSP_Tasks();
+#else
+    if (verify_pending) programStep();
+    else if (lvp && erase_armed && (erase_next < APP_ROWS)) rowErase();
+#endif
+    hexTimeout();
+}
+
+#if !defined(DIRECT_USE_ICSP)
+/**
+ * Self-program a row, comparing first with the flash contents
+ * Rows that already match are skipped altogether, rows that only need 
+ * bits cleared (including those pre-erased) are written without erasing.
+ * The row CRC is summed in the image CRC (blank rows count 0, see 
+ * crcFlashRow), the integrity record words are left blank: data for them
+ * fails the sequence.
+ */
+void flashWrite( uint16_t address, uint16_t *words){
+    uint8_t  i;
+    uint8_t  n = (uint8_t)((address - APP_FLASH) / ROW_SIZE);
+    uint16_t word, old;
+    uint16_t crc = address;
+    uint16_t crc_old = address;
+    uint16_t start;
+    bool     same = true;
+    bool     erase = false;
+    bool     blank = true;
+    bool     blank_old = true;
+
+    for( i=0; i< ROW_SIZE; i++) {
+        if (address + i >= APP_CRC) {   // reserved, an image using them cannot pass
+            if ((words[i] & WORD_MASK) != WORD_MASK) data_lost = true;
+            words[i] = WORD_MASK;
+        }
+        old = appRead( address + i);
+        word = words[i] & WORD_MASK;
+        crc = crcWord( crc, word);
+        crc_old = crcWord( crc_old, old);
+        if (word != WORD_MASK) blank = false;
+        if (old != WORD_MASK) blank_old = false;
+        if (word != old) same = false;
+        if (word & ~old) erase = true;  // a bit needs to go from 0 to 1
+    }
+    if (blank) crc = 0;
+    if (blank_old) crc_old = 0;
+    // a row passed twice replaces its previous contribution
+    if (row_written[ n >> 3] & (1 << (n & 7))) 
+        direct_stats.image_crc -= crc_old;
+    else 
+        direct_stats.rows_written++;
+    row_written[ n >> 3] |= 1 << (n & 7);
+    direct_stats.image_crc += crc;
+    if (same) {
+        direct_stats.rows_skipped++;
+        return;
+    }
+    start = STATS_TIME();
+    if (erase) {
+        FLASH_EraseBlock( address);
+        direct_stats.rows_erased++;
+        erase_armed = true;
+    }
+    STATS_ELAPSED( stats.flash_ticks, start);
+    start = STATS_TIME();
+    for( i=0; i< ROW_SIZE; i+= WRITE_FLASH_BLOCKSIZE) 
+        FLASH_ProgramBlock( address + i, &words[i]);
+    STATS_ELAPSED( stats.flash_ticks, start);
+    direct_stats.rows_programmed++;
+}
+#endif
+
+void lvpWrite( uint32_t address, uint16_t *words){
     // check for first entry in lvp 
-    if (row_address >= CFG_ADDRESS) {    // use the special cfg word sequence
-        //do nothing...
-        //LVP_cfgWrite( &row[7], CFG_NUM);
+    if (address >= CFG_ADDRESS) {    // use the special cfg word sequence
+#if defined(DIRECT_USE_ICSP)
+        if (address == CFG_ADDRESS) 
+            ICSP_ConfigWrite( CFG_ADDRESS + CFG_OFFSET, &words[ CFG_OFFSET], CFG_NUM);
+#endif
     }
     else { // normal row programming sequence
-        if (row_address >=0x1600) {
-            FLASH_WriteBlock(row_address, row);
+#if defined(DIRECT_USE_ICSP)
+        // the target was bulk erased, rows written twice are merged (bits can only be cleared)
+        if (address < TARGET_END_FLASH) {
+            ICSP_RowWrite( (uint16_t)address, words, ROW_SIZE);
+        }
+#else
+        if ((address >= APP_FLASH) && (address < END_FLASH)) {
+            flashWrite( (uint16_t)address, words);
         }
-        //LVP_addressLoad( row_address);
-        //LVP_rowWrite( row, ROW_SIZE);
+#endif
     }
 }
 
-void writeRow( void) {
-    // latch and program a row, skip if blank
+void writeRow( uint8_t n) {
+    // latch and program a cached row, skip if blank
     uint8_t i;
     uint16_t chk = 0xffff;
-    for( i=0; i< ROW_SIZE; i++) chk &= row[i];  // blank check
+    if (row_address[n] == ROW_NONE) return;
+    for( i=0; i< ROW_SIZE; i++) chk &= row[n][i];  // blank check
     if (chk != 0xffff) { 
-        lvpWrite();
-        memset((void*)row, 0xff, sizeof(row));    // fill buffer with blanks
+        lvpWrite( row_address[n], row[n]);
+        memset((void*)row[n], 0xff, sizeof(row[n]));    // fill buffer with blanks
     }
+    row_address[n] = ROW_NONE;
     PWM2_Off();
     LATCbits.LATC3 = !LATCbits.LATC3;
 }
 
+/**
+ * Find the cache entry for a row, allocating one if necessary
+ * On a miss the least recently used entry is programmed and reused. A row
+ * already passed to flash in this sequence (records revisiting it after its
+ * eviction) is re-read first, so that the new records are merged with it.
+ * 
+ * @param address   destination address of the row
+ * @return          cache entry
+ */
+static uint8_t rowSelect( uint32_t address) {
+    uint8_t i, n = 0;
+
+    for( i=0; i< ROW_CACHE; i++) {
+        if (row_address[i] == address) break;
+    }
+    if (i == ROW_CACHE) {       // miss
+        for( i=1; i< ROW_CACHE; i++) {
+            if (row_age[i] > row_age[n]) n = i;
+        }
+        i = n;
+        writeRow( i);
+        row_address[i] = address;
+#if !defined(DIRECT_USE_ICSP)
+        if ((address >= APP_FLASH) && (address < END_FLASH)) {
+            n = (uint8_t)(((uint16_t)address - APP_FLASH) / ROW_SIZE);
+            if (row_written[ n >> 3] & (1 << (n & 7))) {
+                for( n=0; n< ROW_SIZE; n++) 
+                    row[i][n] = FLASH_ReadWord( (uint16_t)address + n);
+            }
+        }
+#endif
+    }
+    for( n=0; n< ROW_CACHE; n++) {
+        if (row_age[n] < 0xff) row_age[n]++;
+    }
+    row_age[i] = 0;
+    return i;
+}
+
 /**
  * Align and pack words in rows, ready for lvp programming
  * @param address       starting address 
@@ -242,164 +696,628 @@ void writeRow( void) {
  * @param data_count    number of bytes 
  */
 void packRow( uint32_t address, uint8_t *data, uint8_t data_count) {
-    // copy only the bytes from the current data packet up to the boundary of a row 
-    uint8_t  index = (address & 0x3e)>>1; 
-    uint32_t new_row = (address & 0xfffc0)>>1;
-    if (new_row != row_address) {
-        writeRow();
-        row_address = new_row;
-    }
+    uint8_t  index;
+    uint16_t *words;
+
     // ensure data is always even (rounding up)
     data_count = (data_count+1) & 0xfe;
-    // copy data up to the row boundaries
-    while ((data_count > 0) && (index < ROW_SIZE)){
-        uint16_t word = *data++;
-        word += ((uint16_t)(*data++)<<8);
-        row[index++] = word;
-        data_count -= 2;
-    }
-    // if a complete row was filled, proceed to programming
-    if (index == ROW_SIZE) { 
-        writeRow();
-        // next consider the split row scenario
-        if (data_count > 0) {   // leftover must spill into next row
-            row_address += ROW_SIZE;
-            index = 0;
-            while (data_count > 0){
-                uint16_t word = *data++;
-                word += ((uint16_t)(*data++)<<8);
-                row[index++] = word;
-                data_count -= 2;
-            }
+    while (data_count > 0) {    // split row scenario: leftover spills into next row
+        index = (uint8_t)((address >> 1) & (ROW_SIZE - 1)); 
+        words = row[ rowSelect( ((address & 0xfffff) >> 1) & ~(uint32_t)(ROW_SIZE - 1))];
+        // copy data up to the row boundaries
+        while ((data_count > 0) && (index < ROW_SIZE)){
+            uint16_t word = *data++;
+            word += ((uint16_t)(*data++)<<8);
+            words[index++] = word;
+            data_count -= 2;
+            address += 2;
         }
     }
 }
 
 void programLastRow( void) {
-    writeRow();
-    //LVP_exit();
+    uint8_t i;
+
+#if defined(SYSTEM_AUTO_RUN) && defined(SYSTEM_BOOT_TIMING)
+    if (lvp) BOOT_TIMING_PIN = 1;   // end of file, low again at the jump
+#endif
+    for( i=0; i< ROW_CACHE; i++) writeRow( i);
+    if (lvp) {
+#if defined(DIRECT_USE_ICSP)
+        ICSP_Exit();    // once the last row (and the config words) are programmed
+        direct_stats.time_ms = (uint16_t)USBGet1msTickCount() - start_ms;
+        if (data_lost) direct_stats.result = DIRECT_RESULT_FAIL;
+#else
+        // rows not in the image are left blank: programStep erases them
+        // between two commands (or while the next packet waits), the 
+        // verification follows
+        verify_pending = true;
+        verify_lost = data_lost;
+        verify_next = 0;
+        direct_stats.flash_crc = 0;
+#endif
+    }
     lvp = false;    
+    data_lost = false;
     LATCbits.LATC3 = 0;
 }
 
-// the actual state machine - Hex Machina
-enum hexstate { SOL, BYTE_COUNT, ADDRESS, RECORD_TYPE, DATA, CHKSUM};
+/**
+ * Program data received with the CDC streaming protocol (stream.c)
+ * @param address   word address
+ * @param data      words, little endian
+ * @param count     number of bytes (even)
+ */
+void DIRECT_StreamWrite( uint16_t address, uint8_t *data, uint8_t count) {
+    programStart();
+    direct_stats.data_bytes += count;
+    packRow( (uint32_t)address << 1, data, count);
+}
 
 /**
- * Parser, main state machine decoding engine
+ * End of a streamed image: program the rows still cached, the verification
+ * follows in the background (see DIRECT_ProgrammingInProgress)
+ */
+void DIRECT_StreamEnd( void) {
+    if (lvp) programLastRow();
+    else if (!verify_pending) direct_stats.result = DIRECT_RESULT_EMPTY;
+}
+
+// Intel HEX record, as decoded bytes
+#define REC_BYTE_COUNT   0
+#define REC_ADDRESS_H    1
+#define REC_ADDRESS_L    2
+#define REC_TYPE         3
+#define REC_DATA         4
+#define REC_MAX_DATA    16
+#define REC_SIZE        (REC_DATA + REC_MAX_DATA + 1)  // + checksum
+
+// ASCII to nibble lookup (in program memory), indexed by (c - '0')
+#define NIBBLE_INVALID  0xff
+#define X               NIBBLE_INVALID
+const uint8_t nibble[] = {
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9,                   // '0'..'9'
+    X, X, X, X, X, X, X,                            // ':'..'@'
+    10, 11, 12, 13, 14, 15,                         // 'A'..'F'
+    X, X, X, X, X, X, X, X, X, X, X, X, X,          // 'G'..'S'
+    X, X, X, X, X, X, X, X, X, X, X, X, X,          // 'T'..'`'
+    10, 11, 12, 13, 14, 15                          // 'a'..'f'
+};
+#undef X
+
+// parser state, preserved across packets
+typedef struct {
+    bool     in_record;             // false = looking for ':' (start of line)
+    bool     low_half;              // true = high nibble already latched
+    uint8_t  high_nibble;
+    uint8_t  rec_index;             // next free position in record[]
+    uint8_t  rec_length;            // total number of bytes in current record
+    uint8_t  checksum;
+    uint8_t  record[ REC_SIZE];
+    uint16_t ext_address;           // upper 16 bits, from the last extended address record
+} HEX_STATE;
+
+static HEX_STATE hex;
+
+// sector re-ordering, see hexSectorStart()
+#define HEAD_SIZE   48              // max leading chars put aside from a sector
+#define HEX_GAPS    2               // heads and tails kept at the same time, one
+                                    // more fails the sequence (see README.md)
+#define HEX_TIMEOUT 3000            // ms without data before the open gaps are given up
+#define RUN_START   0xff            // run parsed from the start of the file
+#define RUN_LOST    0xfe            // run whose head could not be kept
+#define RUN_NONE    0xfd            // no EOF record parsed yet
+#define RUN_HEAD    0xfc            // the entry is a head
+
+typedef struct {                    // a tail or a head, sharing the entries
+    uint16_t  sector;               // tail: sector that will continue it, head: 
+                                    // first sector of the run, 0 = free entry
+    uint8_t   run;                  // tail: head of the run (or RUN_START), RUN_HEAD
+    union {
+        HEX_STATE state;            // end of a run of sectors parsed in sequence,
+                                    // including the record interrupted there
+        struct {                    // start of a run of sectors parsed in sequence
+            uint8_t digits[ HEAD_SIZE / 2]; // hex digits preceding its first record,
+                                            // two per byte (high nibble first)
+            uint8_t count;                  // number of digits
+            bool    line_end;               // the digits are followed by a line end
+        } head;
+    } part;
+} HEX_GAP;
+
+static uint16_t  hex_sector;        // data sector being parsed, 0 = none
+static uint16_t  hex_next;          // sector expected to follow, 0 = start of a file
+static uint8_t   hex_run;           // head of the run being parsed (or RUN_xxx)
+static uint8_t   hex_eof_run;       // run containing the EOF record (or RUN_NONE)
+static uint16_t  hex_ms;            // USB tick of the last data sector
+static HEX_GAP   gaps[ HEX_GAPS];
+
+static void hexComplete( bool timeout);
+
+/**
+ * Execute a complete (checksum verified) record
  * 
- * @param c     input character 
- * @return      true = success, false = decoding failure/invalid file contents
- */
-bool ParseHex(char c)
-{
-    static enum hexstate state = SOL;
-    static uint8_t  bc;
-    static uint8_t  data_count;
-    static uint32_t address;
-    static uint32_t ext_address = 0;
-    static uint8_t  checksum;
-    static uint8_t  record_type;
-    static uint8_t  data_byte, data_index, data[16];
-
-    switch( state){
-        case SOL:
-            if (c == '\r') break;
-            if (c == '\n') break;
-            if (c != ':') return false; 
-            state = BYTE_COUNT;
-            bc = 0;
-            address = 0;
-            checksum = 0;
+ * @return      true = success, false = unsupported record type
+ */
+static bool hexRecord( void)
+{
+    uint16_t address = ((uint16_t)hex.record[ REC_ADDRESS_H] << 8) + hex.record[ REC_ADDRESS_L];
+    uint8_t  count = hex.record[ REC_BYTE_COUNT];
+
+    switch( hex.record[ REC_TYPE]) {
+        case 0:     // data record
+            programStart();
+            direct_stats.data_bytes += count;
+            hex.record[ REC_DATA + count] = 0xff;   // pad odd counts (checksum already used)
+            packRow( ((uint32_t)hex.ext_address << 16) + address, &hex.record[ REC_DATA], count);
             break;
-        case BYTE_COUNT:
-            if ( isDigit( &c) == false) { state = SOL; return false; }
-            bc++;
-            if (bc == 1) 
-                data_count = c;
-            if (bc == 2 )  {  
-                data_count = (data_count << 4) + c;
-                checksum += data_count;
-                bc = 0; 
-                if (data_count > 16) { state = SOL; return false; }
-                state = ADDRESS;
-            }
-            break;            
-        case ADDRESS:
-            if ( isDigit( &c) == false) { state = SOL; return false;}
-            bc++;
-            if (bc == 1) 
-                address = c;
-            else  {  
-                address = (address << 4) + (uint32_t)c;
-                if (bc == 4) {
-                    checksum += (address>>8) + address;
-                    bc = 0; 
-                    state = RECORD_TYPE;
-                }
+        case 1:     // EOF record
+            hex_eof_run = hex_run;
+            hexComplete( false);
+            break;
+        case 4:     // extended address record
+            hex.ext_address = ((uint16_t)(hex.record[ REC_DATA]) << 8) + hex.record[ REC_DATA+1];
+            break;
+        default:
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Parser, decodes a whole packet at a time
+ * Characters are converted to bytes and accumulated in hex.record[], only once
+ * a record is complete is it checked and executed. 
+ * 
+ * @param buffer    input characters 
+ * @param count     number of characters in buffer
+ * @return          true = success, false = decoding failure/invalid file contents
+ */
+bool ParseHex( uint8_t *buffer, uint8_t count)
+{
+    uint8_t c;
+
+    while( count--) {
+        c = *buffer++;
+        if ( !hex.in_record) {
+            if ((c == '\r') || (c == '\n')) continue;
+            if (c != ':') return false; 
+            hex.in_record = true;
+            hex.low_half = false;
+            hex.rec_index = 0;
+            hex.rec_length = REC_DATA + 1;      // until the byte count is known
+            hex.checksum = 0;
+            continue;
+        }
+        // hex digit
+        c -= '0';
+        if ((c >= sizeof( nibble)) || (nibble[c] == NIBBLE_INVALID)) {
+            hex.in_record = false; 
+            return false;
+        }
+        if ( !hex.low_half) {
+            hex.high_nibble = nibble[c] << 4;
+            hex.low_half = true;
+            continue;
+        }
+        hex.low_half = false;
+        c = hex.high_nibble + nibble[c];
+        hex.checksum += c;
+        hex.record[ hex.rec_index++] = c;
+        if (hex.rec_index == REC_DATA) {        // header complete
+            if (hex.record[ REC_BYTE_COUNT] > REC_MAX_DATA) { 
+                hex.in_record = false; 
+                return false; 
             }
-            break;                        
-        case RECORD_TYPE:
-            if ( isDigit( &c) == false) { state = SOL; return false;}
-            bc++;
-            if (bc == 1) 
-                if (c != 0) { state = SOL; return false; }
-            if (bc == 2)  {  
-                record_type = c;
-                checksum += c;
-                bc = 0; 
-                state = DATA;  // default
-                data_index = 0;
-                memset(data, 0xff, sizeof(data));
-                if (record_type == 0) break; // data record
-                if (record_type == 1) { state = CHKSUM; break; }  // EOF record
-                if (record_type == 4) break; // extended address record
-                state = SOL; 
+            hex.rec_length = REC_DATA + hex.record[ REC_BYTE_COUNT] + 1;
+        }
+        if (hex.rec_index == hex.rec_length) {      // record complete
+            hex.in_record = false;
+            if (hex.checksum != 0) {
+                stats.checksum_errors++;
                 return false;
             }
-            break;            
-        case DATA:
-            if ( isDigit( &c) == false) { state = SOL; return false;}
-            bc++;
-            if (bc == 1) 
-                data[data_index] = (c<<4);
-            if (bc == 2)  {  
-                bc = 0;
-                data[data_index] += c;
-                checksum +=  data[data_index];
-                data_index++;
-                if (data_index == data_count) { 
-                    state = CHKSUM; 
-                }
-            }
-            break;            
-        case CHKSUM:
-            if ( isDigit( &c) == false) { state = SOL; return false;}
-            bc++;
-            if (bc == 1) 
-                checksum += (c<<4);
-            if (bc == 2)  {  
-                bc = 0;
-                checksum += c;
-                if (checksum != 0) { 
-                    state = SOL; 
-                    return false; 
-                }
-                // chksum is good 
-                state = SOL; 
-                if (record_type == 0) 
-                    packRow( ext_address + address, data, data_count);
-                else if (record_type == 4) 
-                    ext_address = ((uint32_t)(data[0]) << 24) + ((uint32_t)(data[1]) << 16);
-                else if (record_type == 1) { 
-                    programLastRow();
-                    ext_address = 0;
-                }
-                else return false;
-            }
-            break;            
-        default:
+            if (hexRecord() == false) return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Find the data sector that follows in the file being written 
+ */
+static uint16_t nextSector( uint16_t sector)
+{
+    uint16_t cluster = FATNextCluster( sector - 2);    // 1 sector per cluster
+    return (cluster) ? cluster + 2 : sector + 1;      // assume sequential if unknown
+}
+
+/**
+ * Clear the sector re-ordering state, ready for the start of a file
+ */
+static void hexReset( void)
+{
+    memset( (void*)gaps, 0, sizeof( gaps));
+    hex.in_record = false;
+    hex.ext_address = 0;
+    hex_sector = 0;
+    hex_next = 0;
+    hex_run = RUN_START;
+    hex_eof_run = RUN_NONE;
+    data_lost = false;
+}
+
+static bool hexGapsOpen( void)
+{
+    uint8_t i;
+
+    for( i=0; i < HEX_GAPS; i++) {
+        if (gaps[ i].sector) return true;
+    }
+    return false;
+}
+
+/**
+ * End the sequence once the EOF record has been parsed and the file is whole:
+ * the run containing it reaches back to the start of the file, no gap is left
+ * @param timeout   true = give up the gaps still open, the image is incomplete
+ */
+static void hexComplete( bool timeout)
+{
+    if (timeout) {
+        data_lost = true;
+    }
+    else if ((hex_eof_run != RUN_START) || hexGapsOpen()) {
+        return;
+    }
+    programLastRow();
+    hexReset();
+}
+
+/**
+ * Give up the open gaps once the host has stopped writing (idle loop)
+ */
+static void hexTimeout( void)
+{
+    if ((hex_eof_run == RUN_NONE) && !hexGapsOpen()) return;
+    if (((uint16_t)USBGet1msTickCount() - hex_ms) < HEX_TIMEOUT) return;
+    hexComplete( true);
+}
+
+/**
+ * Put aside the end of the run being parsed until the sector following it
+ * arrives (nothing follows the EOF record)
+ */
+static void hexRunClose( void)
+{
+    uint8_t i;
+
+    if ((hex_next == 0) || (hex_run == hex_eof_run) || (hex_run == RUN_LOST)) return;
+    for( i=0; i < HEX_GAPS; i++) {
+        if (gaps[ i].sector == 0) {
+            gaps[ i].part.state = hex;
+            gaps[ i].sector = hex_next;
+            gaps[ i].run = hex_run;
+            return;
+        }
+    }
+    data_lost = true;
+}
+
+/**
+ * Put aside the leading characters of a sector that starts a new run
+ * The sector is Intel HEX text (see hexText), the characters are the end of
+ * a record: hex digits, then a line end. Anything after the first line end
+ * would only make the record fail again when it is parsed (hexHeadParse).
+ * @return  the entry used, RUN_LOST if none is free
+ */
+static uint8_t hexHeadOpen( uint16_t sector, uint8_t *buffer, uint8_t count)
+{
+    uint8_t n, i, c;
+    HEX_GAP *gap;
+
+    for( n=0; (n < HEX_GAPS) && gaps[ n].sector; n++);
+    if (n == HEX_GAPS) return RUN_LOST;
+    gap = &gaps[ n];
+    gap->sector = sector;
+    gap->run = RUN_HEAD;
+    gap->part.head.line_end = false;
+    for( i=0; i < count; i++) {
+        c = buffer[ i];
+        if ((c == '\r') || (c == '\n')) {
+            gap->part.head.line_end = true;
             break;
+        }
+        c = nibble[ c - '0'];
+        if (i & 1) gap->part.head.digits[ i >> 1] |= c;
+        else gap->part.head.digits[ i >> 1] = c << 4;
+    }
+    gap->part.head.count = i;
+    return n;
+}
+
+/**
+ * Parse the characters put aside by hexHeadOpen, completing the record 
+ * interrupted at the end of the sector that precedes the head
+ */
+static void hexHeadParse( HEX_GAP *gap)
+{
+    uint8_t i, c;
+
+    for( i=0; i < gap->part.head.count; i++) {
+        c = gap->part.head.digits[ i >> 1];
+        c = "0123456789ABCDEF"[ (i & 1) ? (c & 0x0f) : (c >> 4)];
+        if (!ParseHex( &c, 1)) return;
+    }
+    if (gap->part.head.line_end) {
+        c = '\r';
+        ParseHex( &c, 1);
+    }
+}
+
+/**
+ * Check the ordering of a new data sector (segment 0), before it is parsed
+ * Hosts can write the clusters of a file out of order. The sectors received in
+ * sequence form a run; when a sector does not follow the previous one, the end
+ * of the current run (the record interrupted there) is put aside as a tail, 
+ * until the sector continuing it arrives. A sector that does not continue a
+ * run starts a new one, parsed from its first record boundary: the leading 
+ * characters are put aside as a head, until the sector preceding it has been
+ * parsed (see hexSectorEnd). Tails and heads share HEX_GAPS entries (a gap in
+ * the middle of a file takes one on each side), when none is free the data is
+ * dropped and the sequence fails.
+ * 
+ * @param sector    data sector address
+ * @param buffer    first segment of the sector
+ * @return          number of characters to skip at the start of the buffer
+ */
+static uint8_t hexSectorStart( uint16_t sector, uint8_t *buffer)
+{
+    uint8_t   i;
+    uint8_t   run;
+    uint16_t  index;
+    HEX_STATE resume;
+
+    hex_ms = (uint16_t)USBGet1msTickCount();
+    if ((hex_next != 0) && (sector == hex_next)) {    // in sequence
+        hex_sector = sector;
+        return 0;
+    }
+    // resume a run put aside earlier, its entry is freed first
+    for( i=0; i < HEX_GAPS; i++) {
+        if ((gaps[ i].sector == sector) && (gaps[ i].run != RUN_HEAD)) {
+            resume = gaps[ i].part.state;
+            run = gaps[ i].run;
+            gaps[ i].sector = 0;
+            hexRunClose();
+            hex = resume;
+            hex_run = run;
+            hex_sector = sector;
+            return 0;
+        }
+    }
+    hexRunClose();
+    hex_sector = sector;
+    hex.in_record = false;
+    hex.ext_address = 0;                // until an extended address record
+    // start of the file: first cluster of the *.HEX entry or, if not known yet, a
+    // record boundary while no file is in progress
+    index = RootHexIndex( sector - 2);
+    if ((index == 0) || ((index == ROOT_NOT_HEX) && (hex_next == 0) && (buffer[ 0] == ':'))) {
+        hex_run = RUN_START;
+        return 0;
+    }
+    // resynchronize on the first record boundary (or the padding after the file)
+    for( i=0; (i < MSD_OUT_EP_SIZE) && (buffer[ i] != ':') && (buffer[ i] != 0); i++);
+    hex_run = (i > HEAD_SIZE) ? RUN_LOST : hexHeadOpen( sector, buffer, i);
+    if (hex_run == RUN_LOST) data_lost = true;
+    return i;
+}
+
+/**
+ * Complete a data sector (after its last segment has been parsed)
+ * If the following sector was received earlier, complete the record with its
+ * head and carry on from the end of the run it started, repeatedly.
+ */
+static void hexSectorEnd( void)
+{
+    uint8_t n, t;
+
+    if (hex_sector == 0) return;        // the sequence ended in this sector
+    hex_next = nextSector( hex_sector);
+    for( n=0; n < HEX_GAPS; n++) {
+        if ((gaps[ n].run != RUN_HEAD) || (gaps[ n].sector != hex_next) || (n == hex_run)) continue;
+        hexHeadParse( &gaps[ n]);
+        hex_next = nextSector( gaps[ n].sector);
+        gaps[ n].sector = 0;
+        if (hex_eof_run == n) hex_eof_run = hex_run;
+        for( t=0; t < HEX_GAPS; t++) {
+            if (gaps[ t].sector && (gaps[ t].run == n)) {
+                hex = gaps[ t].part.state;
+                hex_next = gaps[ t].sector;
+                gaps[ t].sector = 0;
+                break;
+            }
+        }
+        n = (uint8_t)-1;                // the run may continue into another one
+    }
+    hexComplete( false);
+}
+
+/**
+ * Test if the first segment of a sector can be Intel HEX text: hex digits,
+ * ':' and line ends only, possibly followed by the padding after the file
+ */
+static bool hexText( uint8_t *buffer)
+{
+    uint8_t i;
+    uint8_t c;
+
+    if (buffer[ 0] == 0) return false;
+    for( i=0; i < MSD_OUT_EP_SIZE; i++) {
+        c = buffer[ i];
+        if (c == 0) break;
+        if ((c == ':') || (c == '\r') || (c == '\n')) continue;
+        c -= '0';
+        if ((c >= sizeof( nibble)) || (nibble[ c] == NIBBLE_INVALID)) return false;
+    }
+    for( ; i < MSD_OUT_EP_SIZE; i++) {
+        if (buffer[ i] != 0) return false;
     }
     return true;
 }
+
+/**
+ * Program a segment of a raw binary image (*.BIN)
+ * Each 64 byte segment is packed at its offset from APP_FLASH, 
+ * words in little endian order. The sectors can arrive in any order, the 
+ * sequence ends once all those covering the image have been received.
+ * A file larger than the application area is programmed up to its end and
+ * the sequence fails. The sectors can only be recognized once the directory
+ * entry is known: those written before it are dropped (DIRECT_RESULT_ORDER).
+ * 
+ * @param offset    byte offset of the segment within the file
+ * @param buffer    segment data
+ */
+static void binWrite( uint16_t offset, uint8_t *buffer)
+{
+    uint16_t size = RootBinSize();
+    uint8_t  n = (uint8_t)(offset / 512);
+    uint8_t  i;
+
+    if (size > (END_FLASH - APP_FLASH) * 2) size = (END_FLASH - APP_FLASH) * 2;
+    if (offset < size) {
+        if (size - offset < MSD_OUT_EP_SIZE)    // pad the last segment with blanks
+            memset( (void*)&buffer[ size - offset], 0xff, MSD_OUT_EP_SIZE - (size - offset));
+        programStart();
+        if (RootBinSize() > size) data_lost = true;    // truncated to the application area
+        direct_stats.data_bytes += (size - offset < MSD_OUT_EP_SIZE) ? size - offset : MSD_OUT_EP_SIZE;
+        packRow( (uint32_t)APP_FLASH * 2 + offset, buffer, MSD_OUT_EP_SIZE);
+    }
+    if (!lvp || (n >= BIN_SECTORS) || ((offset & 511) != 512 - MSD_OUT_EP_SIZE)) return;
+    bin_received[ n >> 3] |= 1 << (n & 7);      // whole sector received
+    for( i=0; (uint16_t)i * 512 < size; i++) {
+        if ((bin_received[ i >> 3] & (1 << (i & 7))) == 0) return;
+    }
+    programLastRow();
+}
+
+/*******************************************************************************
+ UF2 block format (github.com/microsoft/uf2)
+ 
+ Each 512 byte sector carries its own header with the target address, so 
+ blocks can be programmed in any order, regardless of the file system layout.
+ The header is latched from segment 0, the payload is packed in rows as it 
+ arrives, the sequence ends once every block number has been received (blocks
+ sent twice are counted once).
+ Target addresses are byte addresses, as in the Intel HEX files. Blocks for
+ another device family are ignored, blocks outside the flash (or the 
+ configuration row) are counted but not programmed.
+ ******************************************************************************/
+#define UF2_MAGIC_START0    0x0A324655UL
+#define UF2_MAGIC_START1    0x9E5D5157UL
+#define UF2_MAGIC_END       0x0AB16F30UL
+#define UF2_FLAG_NOT_MAIN   0x00000001UL    // block not to be written to flash
+#define UF2_FLAG_FAMILY     0x00002000UL    // family_id present
+#define UF2_DATA            32              // offset of the payload
+#define UF2_MAX_DATA        476
+#define UF2_END             (512 - 4 - 7 * MSD_OUT_EP_SIZE) // magic end, in the last segment
+
+typedef struct {
+    uint32_t magic_start0;
+    uint32_t magic_start1;
+    uint32_t flags;
+    uint32_t target_addr;
+    uint32_t payload_size;
+    uint32_t block_no;
+    uint32_t num_blocks;
+    uint32_t family_id;
+} UF2_HEADER;
+
+#if defined(DIRECT_USE_ICSP)
+#define UF2_FAMILY          TARGET_UF2_FAMILY
+#else
+#define UF2_FAMILY          DEVICE_UF2_FAMILY
+#endif
+#define UF2_NONE            0xffff          // block not for this device
+
+static uint32_t uf2_address;        // target address of the payload
+static uint16_t uf2_size;           // payload size, 0 = nothing to program
+static uint16_t uf2_block;          // block number (or UF2_NONE)
+static uint16_t uf2_num_blocks;
+
+/**
+ * Test if a payload falls in the memory programmed
+ * @param address   first byte address
+ * @param end       last byte address + 1
+ */
+static bool uf2InRange( uint32_t address, uint32_t end)
+{
+#if defined(DIRECT_USE_ICSP)
+    // configuration space: only the configuration words are used (lvpWrite)
+    return (end <= (uint32_t)TARGET_END_FLASH * 2) || (address >= (uint32_t)CFG_ADDRESS * 2);
+#else
+    return (address >= (uint32_t)APP_FLASH * 2) && (end <= (uint32_t)END_FLASH * 2);
+#endif
+}
+
+/**
+ * Check for a UF2 block and latch its header (segment 0)
+ * @return  true if the sector is a UF2 block
+ */
+static bool uf2Start( uint8_t *buffer)
+{
+    UF2_HEADER *header = (UF2_HEADER*)buffer;
+
+    if ((header->magic_start0 != UF2_MAGIC_START0) || 
+        (header->magic_start1 != UF2_MAGIC_START1)) return false;
+    uf2_address = header->target_addr;
+    uf2_size = 0;
+    uf2_block = UF2_NONE;
+    if (((header->flags & UF2_FLAG_FAMILY) && (header->family_id != UF2_FAMILY)) ||
+        (header->num_blocks > UF2_MAX_BLOCKS) || (header->block_no >= header->num_blocks)) 
+        return true;                    // not for this device: ignored altogether
+    uf2_block = (uint16_t)header->block_no;
+    if (header->num_blocks != uf2_num_blocks) {     // another file
+        uf2_num_blocks = (uint16_t)header->num_blocks;
+        uf2_blocks = 0;
+        memset((void*)uf2_received, 0, sizeof(uf2_received));
+    }
+    if ((header->flags & UF2_FLAG_NOT_MAIN) ||
+        !uf2InRange( uf2_address, uf2_address + header->payload_size)) 
+        return true;                    // counted, not programmed
+    if ((header->payload_size > UF2_MAX_DATA) || (header->payload_size & 1) || (uf2_address & 1)) {
+        data_lost = true;               // malformed, the image cannot pass
+        return true;
+    }
+    uf2_size = (uint16_t)header->payload_size;
+    return true;
+}
+
+/**
+ * Program the payload found in a segment of a UF2 block
+ */
+static void uf2Write( uint8_t *buffer, uint8_t seg)
+{
+    uint16_t pos = (uint16_t)seg * MSD_OUT_EP_SIZE;
+    uint8_t  first = 0;
+    uint8_t  last = MSD_OUT_EP_SIZE;
+
+    // payload bytes falling in this segment
+    if (pos < UF2_DATA) first = UF2_DATA - pos;
+    if (pos + MSD_OUT_EP_SIZE > UF2_DATA + uf2_size) 
+        last = (UF2_DATA + uf2_size > pos) ? UF2_DATA + uf2_size - pos : 0;
+    if (first < last) {
+        programStart();
+        direct_stats.data_bytes += last - first;
+        packRow( uf2_address + pos + first - UF2_DATA, &buffer[ first], last - first);
+    }
+    if ((seg == 7) && (uf2_block != UF2_NONE) && (*(uint32_t*)&buffer[ UF2_END] == UF2_MAGIC_END)) {
+        if (uf2_received[ uf2_block >> 3] & (1 << (uf2_block & 7))) return;     // sent again
+        uf2_received[ uf2_block >> 3] |= 1 << (uf2_block & 7);
+        if (++uf2_blocks >= uf2_num_blocks) {   // all blocks received
+            programLastRow();
+            uf2_num_blocks = 0;                 // the next file starts afresh
+        }
+    }
+}
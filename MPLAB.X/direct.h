@@ -15,6 +15,9 @@ limitations under the License.
 
 *******************************************************************************/
 
+#ifndef DIRECT_H
+#define DIRECT_H
+
 #include "fileio_config.h"
 #include <fileio.h>
 
@@ -27,7 +30,34 @@ uint32_t DIRECT_CapacityRead(void* config);
 uint8_t DIRECT_WriteProtectStateGet(void* config);
 
 void DIRECT_Initialize( void);
+void DIRECT_Tasks( void);
 bool DIRECT_ProgrammingInProgress( void);
+bool DIRECT_WriteReady( void);
+void DIRECT_StreamWrite( uint16_t address, uint8_t *data, uint8_t count);
+void DIRECT_StreamEnd( void);
+bool DIRECT_AppValid( void);
+
+// result of the last programming sequence
+#define DIRECT_RESULT_NONE  0   // nothing programmed yet (or in progress)
+#define DIRECT_RESULT_PASS  1
+#define DIRECT_RESULT_FAIL  2
+#define DIRECT_RESULT_EMPTY 3   // end of a sequence that received no data
+#define DIRECT_RESULT_ORDER 4   // *.BIN data written before its directory entry, dropped
+
+// programming counters (since power up) and status of the last sequence
+typedef struct {
+    uint16_t rows_programmed;   // rows written (with or without erase)
+    uint16_t rows_erased;       // rows that required an erase before writing
+    uint16_t rows_skipped;      // rows already matching the flash contents
+    uint16_t data_bytes;        // image bytes received
+    uint16_t rows_written;      // rows passed to flash (programmed or skipped)
+    uint16_t image_crc;         // sum of the CRC-16 of each row passed to flash
+    uint16_t flash_crc;         // same, re-read from flash after the end of file
+    uint16_t time_ms;           // duration of the sequence
+    uint8_t  result;            // DIRECT_RESULT_xxx
+} DIRECT_STATS;
+
+extern DIRECT_STATS direct_stats;
 
 #if !defined(DRV_FILEIO_CONFIG_INTERNAL_FLASH_MAX_NUM_FILES_IN_ROOT)
     #define DRV_FILEIO_CONFIG_INTERNAL_FLASH_MAX_NUM_FILES_IN_ROOT 16
@@ -80,3 +110,4 @@ bool DIRECT_ProgrammingInProgress( void);
     #error "Number of root file entries must be a multiple of 16.  Please adjust the definition in the FSconfig.h file."
 #endif
 
+#endif  /* DIRECT_H */
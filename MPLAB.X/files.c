@@ -19,6 +19,7 @@ limitations under the License.
 *******************************************************************************/
  
 #include "files.h"
+#include "stats.h"
 #include "string.h"
 
 //------------------------------------------------------------------------------
@@ -48,7 +49,7 @@ void MasterBootRecordGet( uint8_t * buffer, uint8_t seg)
     // Table of Primary Partitions (16 bytes/entry x 4 entries)
     // Note: Multi-byte fields are in little endian format.
     // Partition Entry 1                                                                             //0x01BE
-        buffer[ 0x1be-0x180] = 0x00;                  // Status - 0x80 (bootable), 0x00 (not bootable), other (error)
+        buffer[ 0x1be - 0x180] = 0x00;                  // Status - 0x80 (bootable), 0x00 (not bootable), other (error)
         buffer[ 0x1bf-0x180] = 0x01;                  // Cylinder
     }
     else { // segment 7: 0x1c0 - 0x1ff 
@@ -72,7 +73,7 @@ void MasterBootRecordGet( uint8_t * buffer, uint8_t seg)
     //Partition Entry 4
     // 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, //0x01EE
     //MBR signature         //0x01FE
-        buffer[ 0x1fe-0x1c0] = 0x55; 
+        buffer[ 0x1fe - 0x1c0] = 0x55; 
         buffer[ 0x1ff-0x1c0] = 0xAA;
     }
 }
@@ -131,7 +132,7 @@ void VolumeBootRecordGet( uint8_t * buffer, uint8_t seg)
 // 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
 // ...
     else {
-        buffer[ 0x1fe-0x1c0] = 0x55; 
+        buffer[ 0x1fe - 0x1c0] = 0x55; 
         buffer[ 0x1ff-0x1c0] = 0xAA;			// signature End of sector (0x55AA)
     }
 }
@@ -147,20 +148,116 @@ void FATRecordInit( void)
 {
 }
 
+/**
+ * Fabricate a single FAT entry
+ */
+static uint16_t fatEntry( uint16_t cluster)
+{
+    if (cluster == 0) return 0xFF8;     // Copy of the media descriptor 0xFF8
+    if (cluster < 3)  return 0xFFF;     // 2 - first/last cluster in short file chain (readme.txt)
+    if (cluster < CURRENT_HEX_CLUSTER + CURRENT_HEX_SECTORS - 1) 
+        return cluster + 1;             // current.hex, contiguous chain
+    if (cluster < CURRENT_HEX_CLUSTER + CURRENT_HEX_SECTORS) 
+        return 0xFFF;
+    if ((cluster == STATUS_CLUSTER) ||  // status.txt, single cluster
+        (cluster == STATS_CLUSTER))     // stats.txt, single cluster
+        return 0xFFF;
+    return 0;                           // free
+}
+
 void FATRecordGet( uint8_t * buffer, uint8_t seg)
 {
-    memset( (void*)buffer, 0, MSD_IN_EP_SIZE);
-    if (seg == 0) {
-        buffer[ 0] = 0xF8;      // Copy of the media descriptor 0xFF8
-        buffer[ 1] = 0xFF;   
-        buffer[ 2] = 0xFF;
-        buffer[ 3] = 0xFF;      // 2 - first/last cluster in short file chain
-        buffer[ 4] = 0x0F;      // readme.htm
+    uint16_t pos = (uint16_t)seg * MSD_IN_EP_SIZE;  // byte offset in the FAT
+    uint16_t entry = (pos / 3) * 2;                 // first entry of the group
+    uint8_t  phase = pos % 3;
+    uint8_t  i;
+
+    for( i=0; i < MSD_IN_EP_SIZE; i++) {
+        if (phase == 0) 
+            buffer[ i] = (uint8_t)fatEntry( entry);
+        else if (phase == 1) 
+            buffer[ i] = (uint8_t)(fatEntry( entry) >> 8) + (uint8_t)(fatEntry( entry+1) << 4);
+        else 
+            buffer[ i] = (uint8_t)(fatEntry( entry+1) >> 4);
+        if (++phase == 3) { 
+            phase = 0; 
+            entry += 2; 
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+// FAT chain shadow, rebuilt from each FAT sector written by the host
+// clusters are mostly allocated in sequence: one bit per cluster marks a link 
+// to the following cluster, only the (few) jumps are recorded in a small table
+
+#define FAT_CLUSTERS    DRV_FILEIO_INTERNAL_FLASH_CONFIG_DRIVE_CAPACITY
+#define FAT_JUMPS       8       // max number of non-sequential links tracked
+#define FAT_EOC         0xFF8   // FAT12 end of chain markers 0xFF8-0xFFF
+
+typedef struct {
+    uint16_t from;
+    uint16_t to;
+} FAT_JUMP;
+
+static uint8_t  fat_next[ FAT_CLUSTERS/8];  // bit set = cluster links to cluster+1
+static FAT_JUMP fat_jump[ FAT_JUMPS];
+static uint8_t  fat_jumps;
+static uint16_t fat_entry;                  // index of entry being decoded
+static uint8_t  fat_phase;                  // position within a 3 byte (2 entries) group
+static uint8_t  fat_byte[ 2];               // bytes of the group received so far
+
+/**
+ * Record the link from cluster to value (FAT12 entry)
+ */
+static void fatLink( uint16_t cluster, uint16_t value)
+{
+    if ((cluster < 2) || (cluster >= FAT_CLUSTERS + 2)) return;
+    if (value == cluster + 1) {
+        fat_next[ (cluster-2) >> 3] |= 1 << ((cluster-2) & 7);
+    }
+    else if ((value >= 2) && (value < FAT_EOC) && (fat_jumps < FAT_JUMPS)) {
+        fat_jump[ fat_jumps].from = cluster;
+        fat_jump[ fat_jumps++].to = value;
     }
 }
 
 void FATRecordSet( uint8_t * buffer, uint8_t seg)
 {   
+    uint8_t i, b;
+
+    if (seg == 0) {
+        memset( (void*)fat_next, 0, sizeof( fat_next));
+        fat_jumps = 0;
+        fat_entry = 0;
+        fat_phase = 0;
+    }
+    // entries are 12-bit packed in groups of 3 bytes, groups straddle segments
+    for( i=0; i < MSD_OUT_EP_SIZE; i++) {
+        b = buffer[ i];
+        if (fat_phase < 2) {
+            fat_byte[ fat_phase++] = b;
+            continue;
+        }
+        fatLink( fat_entry, fat_byte[ 0] + ((uint16_t)(fat_byte[ 1] & 0x0F) << 8));
+        fatLink( fat_entry + 1, (fat_byte[ 1] >> 4) + ((uint16_t)b << 4));
+        fat_entry += 2;
+        fat_phase = 0;
+    }
+}
+
+uint16_t FATNextCluster( uint16_t cluster)
+{
+    uint8_t i;
+
+    if ((cluster < 2) || (cluster >= FAT_CLUSTERS + 2)) return 0;
+    if (fat_next[ (cluster-2) >> 3] & (1 << ((cluster-2) & 7))) 
+        return cluster + 1;
+    for( i=0; i < fat_jumps; i++) {
+        if (fat_jump[ i].from == cluster) 
+            return fat_jump[ i].to;
+    }
+    return 0;
 }
 
 //------------------------------------------------------------------------------
@@ -221,6 +318,78 @@ const uint8_t entry0[ ROOT_ENTRY_SIZE] = {
     sizeof(readme), 0x00, 0x00, 0x00,         // README string size (<256)
 };
 
+ const  uint8_t entry2[ ROOT_ENTRY_SIZE] = {
+    'C','U','R','R','E','N','T',' ',    // File name (exactly 8 characters)
+    'H','E','X',                        // File extension (exactly 3 characters)
+    0x21,           // specify this entry as a read only file
+    0x00,           // Reserved
+    0x00,           // Creation time, fine res 10 ms units (0-199)
+    TIMEL(MAJOR, MINOR, 0),     // Creation time, hour/min/sec
+    TIMEH(MAJOR, MINOR, 0),     // Creation time, hour/min/sec
+    DATEL(YEAR, MONTH, DAY),    // Creation date, YMD 
+    DATEH(YEAR, MONTH, DAY),    // Creation date, YMD
+    
+    DATEL(YEAR, MONTH, DAY),    // Last Access date, YMD
+    DATEH(YEAR, MONTH, DAY),    // Last Access date, YMD
+    0x00, 0x00,     // Extended Attributes
+    
+    TIMEL(MAJOR, MINOR, 0),     // Last Modified time h/m/s
+    TIMEH(MAJOR, MINOR, 0),     // Last Modified time h/m/s
+    DATEL(YEAR, MONTH, DAY),    // Last Modified date, YMD
+    DATEH(YEAR, MONTH, DAY),    // Last Modified date, YMD
+    
+    CURRENT_HEX_CLUSTER, 0x00,  // First FAT cluster
+    CURRENT_HEX_SIZE & 0xff, CURRENT_HEX_SIZE >> 8, 0x00, 0x00, // File size
+};
+
+ const  uint8_t entry3[ ROOT_ENTRY_SIZE] = {
+    'S','T','A','T','U','S',' ',' ',    // File name (exactly 8 characters)
+    'T','X','T',                        // File extension (exactly 3 characters)
+    0x21,           // specify this entry as a read only file
+    0x00,           // Reserved
+    0x00,           // Creation time, fine res 10 ms units (0-199)
+    TIMEL(MAJOR, MINOR, 0),     // Creation time, hour/min/sec
+    TIMEH(MAJOR, MINOR, 0),     // Creation time, hour/min/sec
+    DATEL(YEAR, MONTH, DAY),    // Creation date, YMD 
+    DATEH(YEAR, MONTH, DAY),    // Creation date, YMD
+    
+    DATEL(YEAR, MONTH, DAY),    // Last Access date, YMD
+    DATEH(YEAR, MONTH, DAY),    // Last Access date, YMD
+    0x00, 0x00,     // Extended Attributes
+    
+    TIMEL(MAJOR, MINOR, 0),     // Last Modified time h/m/s
+    TIMEH(MAJOR, MINOR, 0),     // Last Modified time h/m/s
+    DATEL(YEAR, MONTH, DAY),    // Last Modified date, YMD
+    DATEH(YEAR, MONTH, DAY),    // Last Modified date, YMD
+    
+    STATUS_CLUSTER, 0x00,       // First FAT cluster
+    STATUS_SIZE, 0x00, 0x00, 0x00,     // File size
+};
+
+ const  uint8_t entry4[ ROOT_ENTRY_SIZE] = {
+    'S','T','A','T','S',' ',' ',' ',    // File name (exactly 8 characters)
+    'T','X','T',                        // File extension (exactly 3 characters)
+    0x21,           // specify this entry as a read only file
+    0x00,           // Reserved
+    0x00,           // Creation time, fine res 10 ms units (0-199)
+    TIMEL(MAJOR, MINOR, 0),     // Creation time, hour/min/sec
+    TIMEH(MAJOR, MINOR, 0),     // Creation time, hour/min/sec
+    DATEL(YEAR, MONTH, DAY),    // Creation date, YMD 
+    DATEH(YEAR, MONTH, DAY),    // Creation date, YMD
+    
+    DATEL(YEAR, MONTH, DAY),    // Last Access date, YMD
+    DATEH(YEAR, MONTH, DAY),    // Last Access date, YMD
+    0x00, 0x00,     // Extended Attributes
+    
+    TIMEL(MAJOR, MINOR, 0),     // Last Modified time h/m/s
+    TIMEH(MAJOR, MINOR, 0),     // Last Modified time h/m/s
+    DATEL(YEAR, MONTH, DAY),    // Last Modified date, YMD
+    DATEH(YEAR, MONTH, DAY),    // Last Modified date, YMD
+    
+    STATS_CLUSTER, 0x00,        // First FAT cluster
+    STATS_SIZE, 0x00, 0x00, 0x00,      // File size
+};
+
 void RootRecordInit( void)
 {
 }
@@ -233,8 +402,331 @@ void RootRecordGet( uint8_t * buffer, uint8_t seg)
         // add the README.HTM file
         memcpy( (void*)&buffer[ ROOT_ENTRY_SIZE], (const void*)entry1, ROOT_ENTRY_SIZE );
     }
+   else if (seg == 1) {
+        // add the CURRENT.HEX and STATUS.TXT files
+        memcpy( (void*)&buffer[ 0], (const void*)entry2, ROOT_ENTRY_SIZE ); 
+        memcpy( (void*)&buffer[ ROOT_ENTRY_SIZE], (const void*)entry3, ROOT_ENTRY_SIZE );
+    }
+   else if (seg == 2) {
+        // add the STATS.TXT file
+        memcpy( (void*)&buffer[ 0], (const void*)entry4, ROOT_ENTRY_SIZE ); 
+    }
+}
+
+//------------------------------------------------------------------------------
+// CURRENT.HEX data sectors, formatted on the fly from the application memory
+
+const char hex_digit[] = "0123456789ABCDEF";
+const char hex_eof[] = ":00000001FF\r\n";
+
+/**
+ * Get a byte of a CURRENT.HEX data record (checksum excluded)
+ * @param record    record number 
+ * @param index     byte count, address (2), type, data (16)
+ */
+static uint8_t hexRecordField( uint16_t record, uint8_t index)
+{
+    uint16_t address = APP_FLASH + record * HEX_RECORD_WORDS;
+    uint16_t word;
+
+    if (index == 0) return HEX_RECORD_WORDS * 2;
+    if (index == 1) return (uint8_t)((address * 2) >> 8);
+    if (index == 2) return (uint8_t)(address * 2);
+    if (index == 3) return 0;                           // data record
+    word = FLASH_ReadWord( address + ((index - 4) >> 1));
+    return (index & 1) ? (uint8_t)(word >> 8) : (uint8_t)word;
+}
+
+/**
+ * Get a byte of a CURRENT.HEX data record, checksum included
+ */
+static uint8_t hexRecordByte( uint16_t record, uint8_t index)
+{
+    uint8_t sum = 0;
+
+    if (index < 4 + HEX_RECORD_WORDS * 2) 
+        return hexRecordField( record, index);
+    for( index=0; index < 4 + HEX_RECORD_WORDS * 2; index++) 
+        sum += hexRecordField( record, index);
+    return -sum;
+}
+
+void CurrentHexGet( uint8_t* buffer, uint16_t sector, uint8_t seg)
+{
+    uint16_t pos = sector * 512 + (uint16_t)seg * MSD_IN_EP_SIZE;
+    uint16_t record = pos / HEX_RECORD_CHARS;
+    uint8_t  col = pos % HEX_RECORD_CHARS;
+    uint8_t  i, b;
+
+    memset( (void*)buffer, 0, MSD_IN_EP_SIZE);
+    for( i=0; i < MSD_IN_EP_SIZE; i++, col++) {
+        if (col == HEX_RECORD_CHARS) {
+            col = 0;
+            record++;
+        }
+        if (record >= HEX_RECORDS) {            // EOF record, then padding
+            if ((record == HEX_RECORDS) && (col < HEX_EOF_CHARS)) 
+                buffer[ i] = hex_eof[ col];
+            continue;
+        }
+        if (col == 0) 
+            buffer[ i] = ':';
+        else if (col < HEX_RECORD_CHARS - 2) {
+            b = hexRecordByte( record, (col - 1) >> 1);
+            buffer[ i] = hex_digit[ (col & 1) ? (b >> 4) : (b & 0xf)];
+        }
+        else 
+            buffer[ i] = (col == HEX_RECORD_CHARS - 2) ? '\r' : '\n';
+    }
+}
+
+//------------------------------------------------------------------------------
+// STATUS.TXT data sector, formatted from the programming counters
+
+const char result_text[][6] = { "NONE ", "PASS ", "FAIL ", "EMPTY", "ORDER" };
+
+/**
+ * Append a label, followed by a space
+ */
+static uint8_t *putLabel( uint8_t *p, const char *label)
+{
+    while( *label) *p++ = *label++;
+    *p++ = ' ';
+    return p;
+}
+
+/**
+ * Append a value as 4 hex digits, followed by CR LF
+ */
+static uint8_t *putHex( uint8_t *p, uint16_t value)
+{
+    uint8_t i;
+
+    for( i=0; i < 4; i++, value <<= 4) 
+        *p++ = hex_digit[ value >> 12];
+    *p++ = '\r'; *p++ = '\n';
+    return p;
+}
+
+/**
+ * Append a value as 5 decimal digits, followed by CR LF
+ */
+static uint8_t *putDec( uint8_t *p, uint16_t value)
+{
+    uint8_t i;
+
+    for( i=5; i > 0; i--, value /= 10) 
+        p[ i-1] = '0' + (value % 10);
+    p += 5;
+    *p++ = '\r'; *p++ = '\n';
+    return p;
+}
+
+void StatusGet( uint8_t* buffer, uint8_t seg)
+{
+    uint8_t *p = buffer;
+
+    memset( (void*)buffer, 0, MSD_IN_EP_SIZE);
+    if (seg > 0) return;
+    // fixed width, STATUS_SIZE characters in total
+    p = putLabel( p, "RESULT");
+    memcpy( (void*)p, (const void*)result_text[ direct_stats.result], 5);
+    p += 5;
+    *p++ = '\r'; *p++ = '\n';
+    p = putHex( putLabel( p, "CRC"), direct_stats.flash_crc);
+    p = putDec( putLabel( p, "BYTES"), direct_stats.data_bytes);
+    p = putDec( putLabel( p, "ROWS"), direct_stats.rows_written);
+    p = putDec( putLabel( p, "MS"), direct_stats.time_ms);
+}
+
+//------------------------------------------------------------------------------
+// STATS.TXT data sector, one fixed width line per counter
+
+const char stats_label[ STATS_LINES][ 8] = {
+    "WRITE10", "PACKETS", "OUTWAIT", "INWAIT ", "PARSE  ", "CHKSUM ",
+    "ERASED ", "PROGRAM", "SKIPPED", "FLASHMS", "USBMS  ", "MSDMS  ",
+    "CDCPKTS", "CDCFULL", "CDCFILL", "RXLOST "
+};
+
+/**
+ * Convert a time accumulated in STATS ticks to ms (saturated)
+ */
+static uint16_t statsMs( uint32_t ticks)
+{
+    ticks /= STATS_TICKS_PER_MS;
+    return (ticks > 0xFFFF) ? 0xFFFF : (uint16_t)ticks;
+}
+
+static uint16_t statsValue( uint8_t line)
+{
+    switch( line) {
+        case 0:  return stats.write10;
+        case 1:  return stats.packets;
+        case 2:  return stats.out_waits;
+        case 3:  return stats.in_waits;
+        case 4:  return stats.parse_errors;
+        case 5:  return stats.checksum_errors;
+        case 6:  return direct_stats.rows_erased;
+        case 7:  return direct_stats.rows_programmed;
+        case 8:  return direct_stats.rows_skipped;
+        case 9:  return statsMs( stats.flash_ticks);
+        case 10: return statsMs( stats.usb_ticks);
+        case 11: return statsMs( stats.msd_ticks);
+        case 12: return stats.cdc_packets;
+        case 13: return stats.cdc_full;
+        case 14:    // average bytes per CDC IN packet
+            return stats.cdc_packets ? (uint16_t)(stats.cdc_bytes / stats.cdc_packets) : 0;
+        default: return stats.uart_lost;
+    }
+}
+
+void StatsGet( uint8_t* buffer, uint8_t seg)
+{
+    uint8_t  text[ STATS_LINE_CHARS];
+    uint8_t  line, i;
+    uint16_t pos, start = (uint16_t)seg * MSD_IN_EP_SIZE;
+
+    memset( (void*)buffer, 0, MSD_IN_EP_SIZE);
+    // format only the lines overlapping this segment
+    for( line = start / STATS_LINE_CHARS; line < STATS_LINES; line++) {
+        pos = (uint16_t)line * STATS_LINE_CHARS;
+        if (pos >= start + MSD_IN_EP_SIZE) break;
+        memcpy( (void*)text, (const void*)stats_label[ line], 7);
+        text[ 7] = ' ';
+        putDec( &text[ 8], statsValue( line));
+        for( i=0; i < STATS_LINE_CHARS; i++, pos++) {
+            if ((pos >= start) && (pos < start + MSD_IN_EP_SIZE)) 
+                buffer[ pos - start] = text[ i];
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+// Root directory shadow, only the first cluster of the files that are not to 
+// be programmed is retained, their chains are followed on demand
+
+#define ROOT_ENTRIES    DRV_FILEIO_CONFIG_INTERNAL_FLASH_MAX_NUM_FILES_IN_ROOT
+
+static uint16_t root_other[ ROOT_ENTRIES];  // first cluster of each other file, 0 = none
+static uint16_t root_bin;                   // first cluster of the *.BIN image, 0 = none
+static uint16_t root_bin_size;
+static uint16_t root_hex;                   // first cluster of the *.HEX image, 0 = none
+static uint8_t  root_lfn;                   // long name preceding the next short entry
+
+#define LFN_NONE        0                   // none
+#define LFN_NAME        1                   // any name
+#define LFN_APPLEDOUBLE 2                   // "._name", Mac OS resource fork
+
+/**
+ * Latch the first characters of a long name, from its first part (order 1,
+ * the last long name entry before the short entry)
+ */
+static void lfnEntry( uint8_t *entry)
+{
+    if ((entry[ 0] & LFN_ORDER_MASK) != 1) return;
+    // UTF-16 characters 1 and 2
+    root_lfn = ((entry[ 1] == '.') && (entry[ 2] == 0) && (entry[ 3] == '_') && (entry[ 4] == 0)) ?
+            LFN_APPLEDOUBLE : LFN_NAME;
+}
+
+/**
+ * Test if a directory entry describes a file to be programmed (*.HEX, *.BIN)
+ * Mac OS resource forks ("._name.hex") are recognized from their long name,
+ * or without one from their short name alias ("_NAME~1.HEX"): a plain short
+ * name starting with '_' is an image as any other
+ */
+static bool isImageFile( uint8_t *entry)
+{
+    if (root_lfn == LFN_APPLEDOUBLE) return false;
+    if ((root_lfn == LFN_NONE) && (entry[ 0] == '_') && memchr( (void*)entry, '~', 8)) return false;
+    return (memcmp( (void*)&entry[ ENTRY_EXTENSION], (const void*)"HEX", 3) == 0) ||
+           (memcmp( (void*)&entry[ ENTRY_EXTENSION], (const void*)"BIN", 3) == 0);
 }
 
 void RootRecordSet( uint8_t *buffer, uint8_t seg)
 {
+    uint8_t  i, attributes;
+    uint8_t  *entry = buffer;
+    uint16_t cluster;
+
+    if (seg == 0) {
+        memset( (void*)root_other, 0, sizeof( root_other));
+        root_bin = 0;
+        root_hex = 0;
+        root_lfn = LFN_NONE;
+    }
+    for( i = seg * (MSD_OUT_EP_SIZE/ROOT_ENTRY_SIZE); 
+         i < (seg+1) * (MSD_OUT_EP_SIZE/ROOT_ENTRY_SIZE); i++, entry += ROOT_ENTRY_SIZE) {
+        if ((entry[ 0] == 0) || (entry[ 0] == ENTRY_DELETED)) {
+            root_lfn = LFN_NONE;
+            continue;
+        }
+        attributes = entry[ ENTRY_ATTRIBUTES];
+        if (attributes == ATTR_LONG_NAME) {
+            lfnEntry( entry);
+            continue;
+        }
+        if (attributes & ATTR_VOLUME) {
+            root_lfn = LFN_NONE;
+            continue;
+        }
+        cluster = entry[ ENTRY_CLUSTER] + ((uint16_t)entry[ ENTRY_CLUSTER+1] << 8);
+        if ((attributes & ATTR_DIRECTORY) || !isImageFile( entry)) 
+            root_other[ i] = cluster;
+        else if (entry[ ENTRY_EXTENSION] == 'B') {      // raw binary image
+            root_bin = cluster;
+            root_bin_size = (entry[ ENTRY_FILE_SIZE_OFFSET+2] | entry[ ENTRY_FILE_SIZE_OFFSET+3]) ?
+                0xFFFF : entry[ ENTRY_FILE_SIZE_OFFSET] + ((uint16_t)entry[ ENTRY_FILE_SIZE_OFFSET+1] << 8);
+        }
+        else if ((root_hex == 0) && (cluster != CURRENT_HEX_CLUSTER)) {  // Intel HEX image
+            root_hex = cluster;
+        }
+        root_lfn = LFN_NONE;
+    }
+}
+
+bool RootClusterIgnore( uint16_t cluster)
+{
+    uint8_t  i;
+    uint16_t next, n;
+
+    if ((cluster < 2) || (cluster >= FAT_CLUSTERS + 2)) return false;
+    for( i=0; i < ROOT_ENTRIES; i++) {  // chains are short, no bitmap kept in RAM
+        next = root_other[ i];
+        for( n=0; (n < FAT_CLUSTERS) && (next >= 2); n++) {
+            if (next == cluster) return true;
+            next = FATNextCluster( next);
+        }
+    }
+    return false;
+}
+
+uint16_t RootBinOffset( uint16_t cluster)
+{
+    uint16_t next = root_bin;
+    uint16_t offset = 0;
+
+    while ((next >= 2) && (offset < root_bin_size) && (offset < (END_FLASH - APP_FLASH) * 2)) {
+        if (next == cluster) return offset;
+        next = FATNextCluster( next);
+        offset += 512;                  // 1 sector per cluster
+    }
+    return ROOT_NOT_BIN;
+}
+
+uint16_t RootBinSize( void)
+{
+    return root_bin_size;
+}
+
+uint16_t RootHexIndex( uint16_t cluster)
+{
+    uint16_t next = root_hex;
+    uint16_t index;
+
+    for( index=0; (index < FAT_CLUSTERS) && (next >= 2); index++) {
+        if (next == cluster) return index;
+        next = FATNextCluster( next);
+    }
+    return ROOT_NOT_HEX;
 }
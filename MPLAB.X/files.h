@@ -17,6 +17,7 @@ limitations under the License.
 
 #include "system.h"
 #include "direct.h"
+#include "memory.h"
 
 #ifndef FILES_H
 #define	FILES_H
@@ -24,12 +25,39 @@ limitations under the License.
 #define ROOT_ENTRY_SIZE             32  // standard root entry size
 #define ENTRY_FILE_SIZE_OFFSET      28  // offset to entry.file_size field
 #define ENTRY_CLUSTER               26  // offset of entry.cluster 
+#define ENTRY_EXTENSION             8   // offset of entry.extension
+#define ENTRY_ATTRIBUTES            11  // offset of entry.attributes
+#define ENTRY_DELETED               0xE5    // first name character of a deleted entry
+
+#define ATTR_VOLUME                 0x08    // volume label (or long name entry)
+#define ATTR_LONG_NAME              0x0F    // long name entry
+#define LFN_ORDER_MASK              0x1F    // position of a long name entry in its name
+#define ATTR_DIRECTORY              0x10
 
 #define DATEH(y, m, d)    (((y-1980) << 1) + (m >> 3))  // y:1980..2099, m:1..12
 #define DATEL(y, m, d)    ((m << 5) + d)                // d: 1..31
 #define TIMEH(h, m, s)    ((h << 3) +(m >> 3))  // h:0..23, m:0..59
 #define TIMEL(h, m, s)    ((m << 5) + s)        // s = seconds/2 (0-29)
 
+// CURRENT.HEX, read back of the application memory as Intel HEX
+#define HEX_RECORD_WORDS            8   // 16 data bytes per record
+#define HEX_RECORD_CHARS            45  // ":10AAAA00" + 32 data chars + "CC\r\n"
+#define HEX_RECORDS                 ((END_FLASH - APP_FLASH) / HEX_RECORD_WORDS)
+#define HEX_EOF_CHARS               13  // ":00000001FF\r\n"
+#define CURRENT_HEX_SIZE            ((uint16_t)HEX_RECORDS * HEX_RECORD_CHARS + HEX_EOF_CHARS)
+#define CURRENT_HEX_CLUSTER         3   // follows README.TXT
+#define CURRENT_HEX_SECTORS         ((CURRENT_HEX_SIZE + 511) / 512)
+
+// STATUS.TXT, result of the last programming sequence
+#define STATUS_CLUSTER              (CURRENT_HEX_CLUSTER + CURRENT_HEX_SECTORS)
+#define STATUS_SIZE                 59  // see StatusGet()
+
+// STATS.TXT, hot path counters
+#define STATS_CLUSTER               (STATUS_CLUSTER + 1)
+#define STATS_LINES                 16
+#define STATS_LINE_CHARS            15  // 7 chars label, space, 5 digits, CR LF
+#define STATS_SIZE                  (STATS_LINES * STATS_LINE_CHARS)
+
 extern const char readme[];
 
 /** 
@@ -58,6 +86,13 @@ void FATRecordGet( uint8_t* buffer, uint8_t seg);
  */
 void FATRecordSet( uint8_t* buffer, uint8_t seg);
 
+/**
+ * Follows the cluster chain as last written by the host in the FAT
+ * @param cluster
+ * @return  next cluster in the chain, 0 if end of chain or unknown
+ */
+uint16_t FATNextCluster( uint16_t cluster);
+
 /**
  * 
  * @param buffer
@@ -70,6 +105,60 @@ void RootRecordGet( uint8_t* buffer, uint8_t seg);
  */
 void RootRecordSet( uint8_t* buffer, uint8_t seg);
 
+/**
+ * Test if a cluster belongs to a file that is not to be programmed
+ * (any file other than *.HEX or *.BIN, including directories)
+ * @param cluster
+ * @return  true if the cluster can be ignored, false if owned by an image file or unknown
+ */
+bool RootClusterIgnore( uint16_t cluster);
+
+#define ROOT_NOT_BIN    0xFFFF
+
+/**
+ * Locate a cluster in the raw binary image (*.BIN) being written
+ * @param cluster
+ * @return  byte offset of the cluster within the file, ROOT_NOT_BIN if not part of it
+ */
+uint16_t RootBinOffset( uint16_t cluster);
+
+/**
+ * @return  size in bytes of the raw binary image (*.BIN) being written
+ */
+uint16_t RootBinSize( void);
+
+#define ROOT_NOT_HEX    0xFFFF
+
+/**
+ * Locate a cluster in the Intel HEX image (*.HEX) being written
+ * @param cluster
+ * @return  index of the cluster in the file chain, ROOT_NOT_HEX if not part of
+ *          it (or the root directory and FAT not written yet)
+ */
+uint16_t RootHexIndex( uint16_t cluster);
+
+/**
+ * Generates a segment of CURRENT.HEX reading the application memory 
+ * @param buffer
+ * @param sector    sector offset within the file
+ * @param seg
+ */
+void CurrentHexGet( uint8_t* buffer, uint16_t sector, uint8_t seg);
+
+/**
+ * Generates STATUS.TXT from the programming counters
+ * @param buffer
+ * @param seg
+ */
+void StatusGet( uint8_t* buffer, uint8_t seg);
+
+/**
+ * Generates STATS.TXT from the hot path counters
+ * @param buffer
+ * @param seg
+ */
+void StatsGet( uint8_t* buffer, uint8_t seg);
+
 /**
  * Initializes the ROOT directory in RAM
  */
@@ -0,0 +1,200 @@
+/*******************************************************************************
+Copyright 2016 Microchip Technology Inc. (www.microchip.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*******************************************************************************/
+
+#include <xc.h>
+#include "system.h"
+#include "stats.h"
+#include "icsp.h"
+
+// PIC16F188xx 8-bit LVP-ICSP commands
+#define CMD_LOAD_PC         0x80
+#define CMD_BULK_ERASE      0x18
+#define CMD_LOAD_DATA       0x00
+#define CMD_LOAD_DATA_INC   0x02
+#define CMD_BEGIN_INT_PROG  0xE0
+
+// timed operations, in TMR0 ticks (see stats.h), rounded up
+#define ICSP_TPINT          (3 * STATS_TICKS_PER_MS)    // row write, 2.8ms
+#define ICSP_TPINT_CFG      (6 * STATS_TICKS_PER_MS)    // configuration word, 5.6ms
+#define ICSP_TERAB          (9 * STATS_TICKS_PER_MS)    // bulk erase, 8.4ms
+
+#define ICSP_KEY            0x4D434850UL    // "MCHP"
+#define ICSP_CFG_SPACE      0x8000          // bulk erase includes configuration
+
+// states
+#define ICSP_IDLE           0   // target released
+#define ICSP_READY          1   // in LVP mode, waiting for a command
+#define ICSP_BUSY           2   // internally timed operation in progress
+
+static uint8_t  icsp_state = ICSP_IDLE;
+static uint16_t icsp_start;         // STATS_TIME at the start of the timed operation
+static uint16_t icsp_wait;          // its duration
+static bool     icsp_exit;          // release the target when done
+
+// configuration words queued, one timed operation each
+static uint16_t cfg_address;
+static uint16_t cfg_words[ ICSP_CFG_MAX];
+static uint8_t  cfg_index;
+static uint8_t  cfg_count;
+
+/**
+ * Clock out bits, MSB first (the target latches data on the falling edge)
+ */
+static void icspBits( uint32_t data, uint8_t n)
+{
+    uint32_t mask = 1UL << (n - 1);
+
+    while( n--) {
+        ICSP_DAT = (data & mask) ? 1 : 0;
+        ICSP_CLK = 1;
+        mask >>= 1;
+        ICSP_CLK = 0;
+    }
+}
+
+static void icspCommand( uint8_t command)
+{
+    icspBits( command, 8);
+    __delay_us( 1);     // Tdly
+}
+
+/**
+ * 24-bit payload: stop bit, 16 bit field (data shifted left by one), start bit
+ */
+static void icspPayload( uint16_t data)
+{
+    icspBits( (uint32_t)data << 1, 24);
+}
+
+/**
+ * Start an internally timed operation
+ */
+static void icspTimed( uint16_t ticks)
+{
+    icspCommand( CMD_BEGIN_INT_PROG);
+    icsp_start = STATS_TIME();
+    icsp_wait = ticks;
+    icsp_state = ICSP_BUSY;
+}
+
+/**
+ * Load a row and start its programming, the target must be ready
+ */
+static void icspRow( uint16_t address, uint16_t *words, uint8_t count)
+{
+    icspCommand( CMD_LOAD_PC);
+    icspPayload( address);
+    while( --count) {
+        icspCommand( CMD_LOAD_DATA_INC);
+        icspPayload( *words++);
+    }
+    icspCommand( CMD_LOAD_DATA);    // last word, PC still within the row
+    icspPayload( *words);
+    icspTimed( ICSP_TPINT);
+}
+
+/**
+ * Wait for the completion of the timed operation in progress, if any
+ */
+static void icspWait( void)
+{
+    while( icsp_state == ICSP_BUSY) ICSP_Tasks();
+}
+
+void ICSP_Tasks( void)
+{
+    if (icsp_state == ICSP_BUSY) {
+        if ((uint16_t)(STATS_TIME() - icsp_start) < icsp_wait) return;
+        icsp_state = ICSP_READY;
+    }
+    if (icsp_state != ICSP_READY) return;
+    if (cfg_index < cfg_count) {        // next configuration word
+        icspCommand( CMD_LOAD_PC);
+        icspPayload( cfg_address + cfg_index);
+        icspCommand( CMD_LOAD_DATA);
+        icspPayload( cfg_words[ cfg_index++]);
+        icspTimed( ICSP_TPINT_CFG);
+    }
+    else if (icsp_exit) {
+        ICSP_DAT = 0;
+        ICSP_CLK = 0;
+        ICSP_MCLR = 1;
+        icsp_exit = false;
+        icsp_state = ICSP_IDLE;
+    }
+}
+
+bool ICSP_Busy( void)
+{
+    return (icsp_state == ICSP_BUSY) || (cfg_index < cfg_count) || icsp_exit;
+}
+
+bool ICSP_Ready( void)
+{
+    ICSP_Tasks();
+    return (icsp_state != ICSP_BUSY);
+}
+
+void ICSP_Enter( void)
+{
+    while( ICSP_Busy()) ICSP_Tasks();   // previous sequence still completing
+    ICSP_CLK_TRIS = 0;
+    ICSP_DAT_TRIS = 0;
+    ICSP_MCLR_TRIS = 0;
+    ICSP_DAT = 0;
+    ICSP_CLK = 0;
+    ICSP_MCLR = 0;
+    __delay_us( 250);   // Tenth
+    icspBits( ICSP_KEY, 32);
+    __delay_us( 250);   // Tenth
+    icsp_state = ICSP_READY;
+    cfg_index = cfg_count = 0;
+    // erase program memory, user IDs and configuration words
+    icspCommand( CMD_LOAD_PC);
+    icspPayload( ICSP_CFG_SPACE);
+    icspCommand( CMD_BULK_ERASE);
+    icsp_start = STATS_TIME();
+    icsp_wait = ICSP_TERAB;
+    icsp_state = ICSP_BUSY;
+}
+
+void ICSP_RowWrite( uint16_t address, uint16_t *words, uint8_t count)
+{
+    if (count > ICSP_ROW_MAX) count = ICSP_ROW_MAX;
+    icspWait();
+    icspRow( address, words, count);
+}
+
+void ICSP_ConfigWrite( uint16_t address, uint16_t *words, uint8_t count)
+{
+    uint8_t i;
+
+    icspWait();
+    if (count > ICSP_CFG_MAX) count = ICSP_CFG_MAX;
+    for( i=0; i < count; i++) cfg_words[ i] = words[ i];
+    cfg_address = address;
+    cfg_index = 0;
+    cfg_count = count;
+    ICSP_Tasks();       // start the first one
+}
+
+void ICSP_Exit( void)
+{
+    if (icsp_state == ICSP_IDLE) return;
+    icsp_exit = true;
+    ICSP_Tasks();
+}
@@ -0,0 +1,79 @@
+/*******************************************************************************
+Copyright 2016 Microchip Technology Inc. (www.microchip.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*******************************************************************************/
+
+#ifndef ICSP_H
+#define	ICSP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*******************************************************************************
+ LVP-ICSP programming of an external PIC16F188xx target (8-bit command set)
+
+ Commands are clocked out immediately, the internally timed operations (row
+ write, configuration word write, bulk erase) are only started: ICSP_Tasks()
+ polled from the main loop notices their completion, so that the programming
+ delay is spent servicing USB. A row written while the target is still busy
+ waits for it (no copy is queued, RAM is short): the callers hold the next
+ packet until ICSP_Ready().
+ ******************************************************************************/
+
+/**
+ * Enter LVP mode (MCLR low and key sequence) and bulk erase the target
+ */
+void ICSP_Enter( void);
+
+/**
+ * Load a row of words and start its programming, once the target is ready
+ * @param address   word address of the row (row aligned)
+ * @param words     data
+ * @param count     number of words in the row (at most ICSP_ROW_MAX)
+ */
+#define ICSP_ROW_MAX    32
+void ICSP_RowWrite( uint16_t address, uint16_t *words, uint8_t count);
+
+/**
+ * Program configuration words, one timed operation each (queued)
+ * @param address   word address of the first configuration word
+ * @param words     data
+ * @param count     number of words (at most ICSP_CFG_MAX)
+ */
+#define ICSP_CFG_MAX    5
+void ICSP_ConfigWrite( uint16_t address, uint16_t *words, uint8_t count);
+
+/**
+ * Release the target (MCLR high) once all the pending operations are complete
+ */
+void ICSP_Exit( void);
+
+/**
+ * @return  true while a timed operation is in progress or pending
+ */
+bool ICSP_Busy( void);
+
+/**
+ * Advance the state machine and test if a row can be written without waiting
+ * @return  true if no timed operation is in progress
+ */
+bool ICSP_Ready( void);
+
+/**
+ * Advance the state machine, to be called from the main loop
+ */
+void ICSP_Tasks( void);
+
+#endif	/* ICSP_H */
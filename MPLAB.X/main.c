@@ -25,12 +25,16 @@ limitations under the License.
 
 #include "usb.h"
 #include "usb_device_msd.h"
+#include "usb_device_cdc.h"
 
 #include "app_device_msd.h"
+#include "app_device_cdc.h"
 #include "direct.h"
 #include "tmr1.h"
 #include "tmr2.h"
 #include "pwm2.h"
+#include "stats.h"
+#include "memory.h"
 
 /********************************************************************
  * Function:        void main(void)
@@ -38,8 +42,13 @@ limitations under the License.
 inline void goto_app(void) {
     PWM2CONbits.PWM2EN = 0;
     LATCbits.LATC3 = 0;    
-    asm ("movlp 0x16"); 
-    asm ("goto 0x600");    
+    ADCON0bits.ADON = 0;    // as found after reset
+    FVRCONbits.FVREN = 0;
+#if defined(SYSTEM_BOOT_TIMING)
+    BOOT_TIMING_PIN = 0;
+#endif
+    asm ("movlp " ___mkstr(APP_FLASH >> 8)); 
+    asm ("goto " ___mkstr(APP_FLASH & 0x7FF));    
 }
 
 inline void throb(void) {
@@ -62,8 +71,39 @@ inline void throb(void) {
 
 #define charged() (PORTAbits.RA5)
 
+#if defined(SYSTEM_AUTO_RUN)
+/**
+ * Start the application just programmed and verified, without unplugging
+ * Called once the host has collected the status of the last transfer and
+ * left the interfaces idle for SYSTEM_AUTO_RUN_MS. USBDeviceDetach() is 
+ * empty with USB_POLLING, the module is disabled here instead, which releases
+ * the D+ pull up. The loader 
+ * stays off the bus for SYSTEM_DETACH_MS, so that the host sees a disconnect
+ * even if the application attaches again at once, and switches off the 
+ * interrupt sources it enabled before the jump.
+ */
+void run_app(void) {
+    uint8_t i;
+
+    UCONbits.SUSPND = 0;    // resumed before the module is disabled
+    UCON = 0;               // detached
+    UIE = 0;
+    INTCONbits.GIE = 0;
+    INTCONbits.TMR0IE = 0;  // STATS timestamps
+    PIE1 = 0;
+    RCSTA = 0;              // UART released
+    for( i=0; i < SYSTEM_DETACH_MS; i++) __delay_ms( 1);
+    goto_app();
+}
+#endif
+
 void run_usb(void) {
-    USBDeviceInit();
+    uint16_t start;
+#if defined(SYSTEM_AUTO_RUN)
+    uint32_t run_ms = 0;    // USB tick of the last activity after the image was verified
+#endif
+    
+    USBDeviceInit();        // the only one, SYSTEM_Initialize() leaves USB alone
     USBDeviceAttach();
     TMR1_Initialize();
     TMR1_StartTimer();
@@ -75,7 +115,9 @@ void run_usb(void) {
         SYSTEM_Tasks();
 
         #if defined(USB_POLLING)
+            start = STATS_TIME();
             USBDeviceTasks();
+            STATS_ELAPSED( stats.usb_ticks, start);
         #endif
             if (charged()) {
                 PWM2_Off();
@@ -105,27 +147,65 @@ void run_usb(void) {
             continue;
         }
         //Application specific tasks
+        start = STATS_TIME();
         APP_DeviceMSDTasks();
+        STATS_ELAPSED( stats.msd_ticks, start);
+        APP_DeviceCDCEmulatorTasks();
+
+#if defined(SYSTEM_AUTO_RUN)
+        if (direct_stats.result == DIRECT_RESULT_PASS) {
+            // CSW collected (and CDC reply of a streamed image sent), no 
+            // new command since: the host is done with the drive
+            if ((MSD_State != MSD_WAIT) || USBHandleBusy( USBMSDInHandle) || 
+                    !USBUSARTIsTxTrfReady()) {
+                run_ms = USBGet1msTickCount();
+            }
+            else if (USBGet1msTickCount() - run_ms >= SYSTEM_AUTO_RUN_MS) {
+                run_app();
+            }
+        }
+        else {
+            run_ms = USBGet1msTickCount();
+        }
+#endif
     }//end while    
 }
 
+/**
+ * Measure the FVR (2.048V) against VDD: USB power (5V) reads below 476
+ * Runs straight out of reset, before the PLL and the USB module are started:
+ * the ADC uses its own FRC clock, the FVR settling time is its ready flag.
+ */
 bool isUSBPower(void) {
+    FVRCONbits.ADFVR = 2;
+    FVRCONbits.FVREN = 1;
+    ADCON0bits.CHS = 0b11111;
+    ADCON1bits.ADCS = 0b111;
+    ADCON1bits.ADFM = 1;
+    ADCON0bits.ADON = 1;
+    while (FVRCONbits.FVRRDY == 0);
+    _delay(1);              // acquisition (5us): 1 cycle is 8us at the 500kHz reset clock
     ADCON0bits.GO = 1;
     while (ADCON0bits.GO == 1);
     return (ADRES < 476);
 }
 
-
 MAIN_RETURN main(void)
 {
+#if defined(SYSTEM_BOOT_TIMING)
+    BOOT_TIMING_TRIS = 0;
+    BOOT_TIMING_PIN = 1;
+#endif
+    // fast boot: decide before waiting for the PLL or initialising USB
+    if (!isUSBPower() && DIRECT_AppValid()) {
+        goto_app();
+    }
     SYSTEM_Initialize();
     LATAbits.LATA5 = 0;
-    __delay_ms(1);
-    if (isUSBPower()) {
-        run_usb();
-    } else {
-        goto_app();
-    } 
+#if defined(SYSTEM_BOOT_TIMING)
+    BOOT_TIMING_PIN = 0;
+#endif
+    run_usb();
 }//end main
 
 
@@ -171,6 +251,7 @@ bool USER_USB_CALLBACK_EVENT_HANDLER(USB_EVENT event, void *pdata, uint16_t size
             /* When the device is configured, we can (re)initialize the demo
              * code. */
             APP_DeviceMSDInitialize();
+            APP_DeviceCDCEmulatorInitialize();
 
             break;
 
@@ -181,6 +262,7 @@ bool USER_USB_CALLBACK_EVENT_HANDLER(USB_EVENT event, void *pdata, uint16_t size
             /* We have received a non-standard USB request.  The MSD driver
              * needs to check to see if the request was for it. */
             USBCheckMSDRequest();
+            USBCheckCDCRequest();
 
             break;
 
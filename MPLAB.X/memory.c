@@ -55,9 +55,42 @@
   Section: Flash Module APIs
 */
 
+uint16_t FLASH_ReadWord(uint16_t flashAddr)
+{
+    uint8_t GIEBitValue = INTCONbits.GIE;   // Save interrupt enable
+
+    INTCONbits.GIE = 0;     // Disable interrupts
+    PMADRL = (flashAddr & 0x00FF);
+    PMADRH = ((flashAddr & 0xFF00) >> 8);
+
+    PMCON1bits.CFGS = 0;    // Deselect Configuration space
+    PMCON1bits.RD = 1;      // Initiate Read
+    NOP();
+    NOP();
+    INTCONbits.GIE = GIEBitValue;	// Restore interrupt enable
+
+    return ((uint16_t)((PMDATH << 8) | PMDATL));
+}
+
 int8_t FLASH_WriteBlock(uint16_t writeAddr, uint16_t *flashWordArray)
 {
     uint16_t    blockStartAddr  = (uint16_t )(writeAddr & ((END_FLASH-1) ^ (ERASE_FLASH_BLOCKSIZE-1)));
+
+    // Flash write must start at the beginning of a row
+    if( writeAddr != blockStartAddr )
+    {
+        return -1;
+    }
+
+    // Block erase sequence
+    FLASH_EraseBlock(writeAddr);
+
+    return FLASH_ProgramBlock(writeAddr, flashWordArray);
+}
+
+int8_t FLASH_ProgramBlock(uint16_t writeAddr, uint16_t *flashWordArray)
+{
+    uint16_t    blockStartAddr  = (uint16_t )(writeAddr & ((END_FLASH-1) ^ (WRITE_FLASH_BLOCKSIZE-1)));
     uint8_t     GIEBitValue = INTCONbits.GIE;   // Save interrupt enable
     uint8_t i;
 
@@ -69,9 +102,6 @@ int8_t FLASH_WriteBlock(uint16_t writeAddr, uint16_t *flashWordArray)
 
     INTCONbits.GIE = 0;         // Disable interrupts
 
-    // Block erase sequence
-    FLASH_EraseBlock(writeAddr);
-
     // Block write sequence
     PMCON1bits.CFGS = 0;    // Deselect Configuration space
     PMCON1bits.WREN = 1;    // Enable wrties
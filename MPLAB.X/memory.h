@@ -53,6 +53,7 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include "device.h"
 
 #ifdef __cplusplus  // Provide C++ Compatibility
 
@@ -64,15 +65,48 @@
   Section: Macro Declarations
 */
 
-#define WRITE_FLASH_BLOCKSIZE    32
-#define ERASE_FLASH_BLOCKSIZE    32
-#define END_FLASH                0x2000
+#define WRITE_FLASH_BLOCKSIZE    DEVICE_WRITE_SIZE
+#define ERASE_FLASH_BLOCKSIZE    DEVICE_ERASE_SIZE
+#define END_FLASH                DEVICE_END_FLASH
+#define APP_FLASH                DEVICE_APP_FLASH   // start of the application (end of the loader)
+
+// application integrity record, top of the last application row: reserved,
+// never programmed from an image (the application must not use these words)
+#define APP_CRC                  (END_FLASH - 3)    // image CRC, low byte then high byte
+#define APP_MARKER               (END_FLASH - 1)    // commit marker, written last
+#define APP_COMMITTED            0x2AC5             // marker value of a verified image
 
 /**
   Section: Flash Module APIs
 */
 
 
+/**
+  @Summary
+    Reads a word from Flash
+
+  @Description
+    This routine reads a word from given Flash address
+
+  @Preconditions
+    None
+
+  @Param
+    flashAddr - Flash program memory location from which data has to be read
+
+  @Returns
+    Data word read from given Flash address
+
+  @Example
+    <code>
+    uint16_t    readWord;
+    uint16_t    flashAddr = 0x01C0;
+
+    readWord = FLASH_ReadWord(flashAddr);
+    </code>
+*/
+uint16_t FLASH_ReadWord(uint16_t flashAddr);
+
 /**
   @Summary
     Writes data to complete block of Flash
@@ -109,6 +143,35 @@
 */
 int8_t FLASH_WriteBlock(uint16_t writeAddr, uint16_t *flashWordArray);
 
+/**
+  @Summary
+    Writes data to complete block of Flash, without erasing it first
+
+  @Description
+    This routine loads the write latches and writes a complete block in Flash
+    program memory. Being a write only sequence, bits can only be cleared:
+    the block must either be blank or its current contents must have no
+    bit set to '0' that 'flashWordArray' requires to be '1'.
+
+  @Preconditions
+    None
+
+  @Param
+    writeAddr         - A valid block starting address in Flash
+    *flashWordArray   - Pointer to an array of size 'WRITE_FLASH_BLOCKSIZE' at least
+
+  @Returns
+    -1, if the given address is not a valid block starting address of Flash
+    0, in case of valid block starting address
+
+  @Example
+    <code>
+    FLASH_EraseBlock((uint16_t)FLASH_ROW_ADDRESS);
+    FLASH_ProgramBlock((uint16_t)FLASH_ROW_ADDRESS, (uint16_t*)wrBlockData);
+    </code>
+*/
+int8_t FLASH_ProgramBlock(uint16_t writeAddr, uint16_t *flashWordArray);
+
 /**
   @Summary
     Erases complete Flash program memory block
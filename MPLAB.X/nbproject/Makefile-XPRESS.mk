@@ -57,17 +57,17 @@ OBJECTDIR=build/${CND_CONF}/${IMAGE_TYPE}
 DISTDIR=dist/${CND_CONF}/${IMAGE_TYPE}
 
 # Source Files Quoted if spaced
-SOURCEFILES_QUOTED_IF_SPACED=system_config/XPRESS/system.c main.c usb_descriptors.c app_device_msd.c files.c direct.c memory.c tmr1.c /home/phil/Projects/XPRESS-Loader/MPLAB.X/tmr2.c /home/phil/Projects/XPRESS-Loader/MPLAB.X/pwm2.c ../framework/usb/src/usb_device.c ../framework/usb/src/usb_device_msd.c
+SOURCEFILES_QUOTED_IF_SPACED=system_config/XPRESS/system.c main.c usb_descriptors.c app_device_msd.c app_device_cdc.c files.c direct.c memory.c stats.c icsp.c uart.c stream.c tmr1.c /home/phil/Projects/XPRESS-Loader/MPLAB.X/tmr2.c /home/phil/Projects/XPRESS-Loader/MPLAB.X/pwm2.c ../framework/usb/src/usb_device.c ../framework/usb/src/usb_device_cdc.c ../framework/usb/src/usb_device_msd.c
 
 # Object Files Quoted if spaced
-OBJECTFILES_QUOTED_IF_SPACED=${OBJECTDIR}/system_config/XPRESS/system.p1 ${OBJECTDIR}/main.p1 ${OBJECTDIR}/usb_descriptors.p1 ${OBJECTDIR}/app_device_msd.p1 ${OBJECTDIR}/files.p1 ${OBJECTDIR}/direct.p1 ${OBJECTDIR}/memory.p1 ${OBJECTDIR}/tmr1.p1 ${OBJECTDIR}/_ext/1725858440/tmr2.p1 ${OBJECTDIR}/_ext/1725858440/pwm2.p1 ${OBJECTDIR}/_ext/2142726457/usb_device.p1 ${OBJECTDIR}/_ext/2142726457/usb_device_msd.p1
-POSSIBLE_DEPFILES=${OBJECTDIR}/system_config/XPRESS/system.p1.d ${OBJECTDIR}/main.p1.d ${OBJECTDIR}/usb_descriptors.p1.d ${OBJECTDIR}/app_device_msd.p1.d ${OBJECTDIR}/files.p1.d ${OBJECTDIR}/direct.p1.d ${OBJECTDIR}/memory.p1.d ${OBJECTDIR}/tmr1.p1.d ${OBJECTDIR}/_ext/1725858440/tmr2.p1.d ${OBJECTDIR}/_ext/1725858440/pwm2.p1.d ${OBJECTDIR}/_ext/2142726457/usb_device.p1.d ${OBJECTDIR}/_ext/2142726457/usb_device_msd.p1.d
+OBJECTFILES_QUOTED_IF_SPACED=${OBJECTDIR}/system_config/XPRESS/system.p1 ${OBJECTDIR}/main.p1 ${OBJECTDIR}/usb_descriptors.p1 ${OBJECTDIR}/app_device_msd.p1 ${OBJECTDIR}/app_device_cdc.p1 ${OBJECTDIR}/files.p1 ${OBJECTDIR}/direct.p1 ${OBJECTDIR}/memory.p1 ${OBJECTDIR}/stats.p1 ${OBJECTDIR}/icsp.p1 ${OBJECTDIR}/uart.p1 ${OBJECTDIR}/stream.p1 ${OBJECTDIR}/tmr1.p1 ${OBJECTDIR}/_ext/1725858440/tmr2.p1 ${OBJECTDIR}/_ext/1725858440/pwm2.p1 ${OBJECTDIR}/_ext/2142726457/usb_device.p1 ${OBJECTDIR}/_ext/2142726457/usb_device_cdc.p1 ${OBJECTDIR}/_ext/2142726457/usb_device_msd.p1
+POSSIBLE_DEPFILES=${OBJECTDIR}/system_config/XPRESS/system.p1.d ${OBJECTDIR}/main.p1.d ${OBJECTDIR}/usb_descriptors.p1.d ${OBJECTDIR}/app_device_msd.p1.d ${OBJECTDIR}/app_device_cdc.p1.d ${OBJECTDIR}/files.p1.d ${OBJECTDIR}/direct.p1.d ${OBJECTDIR}/memory.p1.d ${OBJECTDIR}/stats.p1.d ${OBJECTDIR}/icsp.p1.d ${OBJECTDIR}/uart.p1.d ${OBJECTDIR}/stream.p1.d ${OBJECTDIR}/tmr1.p1.d ${OBJECTDIR}/_ext/1725858440/tmr2.p1.d ${OBJECTDIR}/_ext/1725858440/pwm2.p1.d ${OBJECTDIR}/_ext/2142726457/usb_device.p1.d ${OBJECTDIR}/_ext/2142726457/usb_device_cdc.p1.d ${OBJECTDIR}/_ext/2142726457/usb_device_msd.p1.d
 
 # Object Files
-OBJECTFILES=${OBJECTDIR}/system_config/XPRESS/system.p1 ${OBJECTDIR}/main.p1 ${OBJECTDIR}/usb_descriptors.p1 ${OBJECTDIR}/app_device_msd.p1 ${OBJECTDIR}/files.p1 ${OBJECTDIR}/direct.p1 ${OBJECTDIR}/memory.p1 ${OBJECTDIR}/tmr1.p1 ${OBJECTDIR}/_ext/1725858440/tmr2.p1 ${OBJECTDIR}/_ext/1725858440/pwm2.p1 ${OBJECTDIR}/_ext/2142726457/usb_device.p1 ${OBJECTDIR}/_ext/2142726457/usb_device_msd.p1
+OBJECTFILES=${OBJECTDIR}/system_config/XPRESS/system.p1 ${OBJECTDIR}/main.p1 ${OBJECTDIR}/usb_descriptors.p1 ${OBJECTDIR}/app_device_msd.p1 ${OBJECTDIR}/app_device_cdc.p1 ${OBJECTDIR}/files.p1 ${OBJECTDIR}/direct.p1 ${OBJECTDIR}/memory.p1 ${OBJECTDIR}/stats.p1 ${OBJECTDIR}/icsp.p1 ${OBJECTDIR}/uart.p1 ${OBJECTDIR}/stream.p1 ${OBJECTDIR}/tmr1.p1 ${OBJECTDIR}/_ext/1725858440/tmr2.p1 ${OBJECTDIR}/_ext/1725858440/pwm2.p1 ${OBJECTDIR}/_ext/2142726457/usb_device.p1 ${OBJECTDIR}/_ext/2142726457/usb_device_cdc.p1 ${OBJECTDIR}/_ext/2142726457/usb_device_msd.p1
 
 # Source Files
-SOURCEFILES=system_config/XPRESS/system.c main.c usb_descriptors.c app_device_msd.c files.c direct.c memory.c tmr1.c /home/phil/Projects/XPRESS-Loader/MPLAB.X/tmr2.c /home/phil/Projects/XPRESS-Loader/MPLAB.X/pwm2.c ../framework/usb/src/usb_device.c ../framework/usb/src/usb_device_msd.c
+SOURCEFILES=system_config/XPRESS/system.c main.c usb_descriptors.c app_device_msd.c app_device_cdc.c files.c direct.c memory.c stats.c icsp.c uart.c stream.c tmr1.c /home/phil/Projects/XPRESS-Loader/MPLAB.X/tmr2.c /home/phil/Projects/XPRESS-Loader/MPLAB.X/pwm2.c ../framework/usb/src/usb_device.c ../framework/usb/src/usb_device_cdc.c ../framework/usb/src/usb_device_msd.c
 
 
 
@@ -126,6 +126,14 @@ ${OBJECTDIR}/app_device_msd.p1: app_device_msd.c  nbproject/Makefile-${CND_CONF}
 	@-${MV} ${OBJECTDIR}/app_device_msd.d ${OBJECTDIR}/app_device_msd.p1.d 
 	@${FIXDEPS} ${OBJECTDIR}/app_device_msd.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
 	
+${OBJECTDIR}/app_device_cdc.p1: app_device_cdc.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/app_device_cdc.p1.d 
+	@${RM} ${OBJECTDIR}/app_device_cdc.p1 
+	${MP_CC} --pass1 $(MP_EXTRA_CC_PRE) --chip=$(MP_PROCESSOR_OPTION) -Q -G  -D__DEBUG=1  --debugger=pickit3  --double=24 --float=24 --rom=0-7FF,800-FFF,1000-15FF --opt=+asm,-asmfile,-speed,+space,-debug,-local --addrqual=require --mode=pro -P -N255 -I"." -I"../framework/usb/inc" -I"../bsp/XPRESS" -I"system_config/XPRESS" -I"../framework" -I"../framework/fileio/inc" --warn=0 --asmlist -DXPRJ_XPRESS=$(CND_CONF)  --summary=default,-psect,-class,+mem,+hex,+file --output=default,-inhx032 --runtime=default,+clear,+init,-keep,-no_startup,-osccal,-resetbits,-download,-stackcall,+clib $(COMPARISON_BUILD)  --output=-mcof,+elf:multilocs --stack=compiled:auto:auto "--errformat=%f:%l: error: (%n) %s" "--warnformat=%f:%l: warning: (%n) %s" "--msgformat=%f:%l: advisory: (%n) %s"     -o${OBJECTDIR}/app_device_cdc.p1 app_device_cdc.c 
+	@-${MV} ${OBJECTDIR}/app_device_cdc.d ${OBJECTDIR}/app_device_cdc.p1.d 
+	@${FIXDEPS} ${OBJECTDIR}/app_device_cdc.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
+	
 ${OBJECTDIR}/files.p1: files.c  nbproject/Makefile-${CND_CONF}.mk
 	@${MKDIR} "${OBJECTDIR}" 
 	@${RM} ${OBJECTDIR}/files.p1.d 
@@ -150,6 +158,38 @@ ${OBJECTDIR}/memory.p1: memory.c  nbproject/Makefile-${CND_CONF}.mk
 	@-${MV} ${OBJECTDIR}/memory.d ${OBJECTDIR}/memory.p1.d 
 	@${FIXDEPS} ${OBJECTDIR}/memory.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
 	
+${OBJECTDIR}/stats.p1: stats.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/stats.p1.d 
+	@${RM} ${OBJECTDIR}/stats.p1 
+	${MP_CC} --pass1 $(MP_EXTRA_CC_PRE) --chip=$(MP_PROCESSOR_OPTION) -Q -G  -D__DEBUG=1  --debugger=pickit3  --double=24 --float=24 --rom=0-7FF,800-FFF,1000-15FF --opt=+asm,-asmfile,-speed,+space,-debug,-local --addrqual=require --mode=pro -P -N255 -I"." -I"../framework/usb/inc" -I"../bsp/XPRESS" -I"system_config/XPRESS" -I"../framework" -I"../framework/fileio/inc" --warn=0 --asmlist -DXPRJ_XPRESS=$(CND_CONF)  --summary=default,-psect,-class,+mem,+hex,+file --output=default,-inhx032 --runtime=default,+clear,+init,-keep,-no_startup,-osccal,-resetbits,-download,-stackcall,+clib $(COMPARISON_BUILD)  --output=-mcof,+elf:multilocs --stack=compiled:auto:auto "--errformat=%f:%l: error: (%n) %s" "--warnformat=%f:%l: warning: (%n) %s" "--msgformat=%f:%l: advisory: (%n) %s"     -o${OBJECTDIR}/stats.p1 stats.c 
+	@-${MV} ${OBJECTDIR}/stats.d ${OBJECTDIR}/stats.p1.d 
+	@${FIXDEPS} ${OBJECTDIR}/stats.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
+	
+${OBJECTDIR}/icsp.p1: icsp.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/icsp.p1.d 
+	@${RM} ${OBJECTDIR}/icsp.p1 
+	${MP_CC} --pass1 $(MP_EXTRA_CC_PRE) --chip=$(MP_PROCESSOR_OPTION) -Q -G  -D__DEBUG=1  --debugger=pickit3  --double=24 --float=24 --rom=0-7FF,800-FFF,1000-15FF --opt=+asm,-asmfile,-speed,+space,-debug,-local --addrqual=require --mode=pro -P -N255 -I"." -I"../framework/usb/inc" -I"../bsp/XPRESS" -I"system_config/XPRESS" -I"../framework" -I"../framework/fileio/inc" --warn=0 --asmlist -DXPRJ_XPRESS=$(CND_CONF)  --summary=default,-psect,-class,+mem,+hex,+file --output=default,-inhx032 --runtime=default,+clear,+init,-keep,-no_startup,-osccal,-resetbits,-download,-stackcall,+clib $(COMPARISON_BUILD)  --output=-mcof,+elf:multilocs --stack=compiled:auto:auto "--errformat=%f:%l: error: (%n) %s" "--warnformat=%f:%l: warning: (%n) %s" "--msgformat=%f:%l: advisory: (%n) %s"     -o${OBJECTDIR}/icsp.p1 icsp.c 
+	@-${MV} ${OBJECTDIR}/icsp.d ${OBJECTDIR}/icsp.p1.d 
+	@${FIXDEPS} ${OBJECTDIR}/icsp.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
+	
+${OBJECTDIR}/uart.p1: uart.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/uart.p1.d 
+	@${RM} ${OBJECTDIR}/uart.p1 
+	${MP_CC} --pass1 $(MP_EXTRA_CC_PRE) --chip=$(MP_PROCESSOR_OPTION) -Q -G  -D__DEBUG=1  --debugger=pickit3  --double=24 --float=24 --rom=0-7FF,800-FFF,1000-15FF --opt=+asm,-asmfile,-speed,+space,-debug,-local --addrqual=require --mode=pro -P -N255 -I"." -I"../framework/usb/inc" -I"../bsp/XPRESS" -I"system_config/XPRESS" -I"../framework" -I"../framework/fileio/inc" --warn=0 --asmlist -DXPRJ_XPRESS=$(CND_CONF)  --summary=default,-psect,-class,+mem,+hex,+file --output=default,-inhx032 --runtime=default,+clear,+init,-keep,-no_startup,-osccal,-resetbits,-download,-stackcall,+clib $(COMPARISON_BUILD)  --output=-mcof,+elf:multilocs --stack=compiled:auto:auto "--errformat=%f:%l: error: (%n) %s" "--warnformat=%f:%l: warning: (%n) %s" "--msgformat=%f:%l: advisory: (%n) %s"     -o${OBJECTDIR}/uart.p1 uart.c 
+	@-${MV} ${OBJECTDIR}/uart.d ${OBJECTDIR}/uart.p1.d 
+	@${FIXDEPS} ${OBJECTDIR}/uart.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
+	
+${OBJECTDIR}/stream.p1: stream.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/stream.p1.d 
+	@${RM} ${OBJECTDIR}/stream.p1 
+	${MP_CC} --pass1 $(MP_EXTRA_CC_PRE) --chip=$(MP_PROCESSOR_OPTION) -Q -G  -D__DEBUG=1  --debugger=pickit3  --double=24 --float=24 --rom=0-7FF,800-FFF,1000-15FF --opt=+asm,-asmfile,-speed,+space,-debug,-local --addrqual=require --mode=pro -P -N255 -I"." -I"../framework/usb/inc" -I"../bsp/XPRESS" -I"system_config/XPRESS" -I"../framework" -I"../framework/fileio/inc" --warn=0 --asmlist -DXPRJ_XPRESS=$(CND_CONF)  --summary=default,-psect,-class,+mem,+hex,+file --output=default,-inhx032 --runtime=default,+clear,+init,-keep,-no_startup,-osccal,-resetbits,-download,-stackcall,+clib $(COMPARISON_BUILD)  --output=-mcof,+elf:multilocs --stack=compiled:auto:auto "--errformat=%f:%l: error: (%n) %s" "--warnformat=%f:%l: warning: (%n) %s" "--msgformat=%f:%l: advisory: (%n) %s"     -o${OBJECTDIR}/stream.p1 stream.c 
+	@-${MV} ${OBJECTDIR}/stream.d ${OBJECTDIR}/stream.p1.d 
+	@${FIXDEPS} ${OBJECTDIR}/stream.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
+	
 ${OBJECTDIR}/tmr1.p1: tmr1.c  nbproject/Makefile-${CND_CONF}.mk
 	@${MKDIR} "${OBJECTDIR}" 
 	@${RM} ${OBJECTDIR}/tmr1.p1.d 
@@ -182,6 +222,14 @@ ${OBJECTDIR}/_ext/2142726457/usb_device.p1: ../framework/usb/src/usb_device.c  n
 	@-${MV} ${OBJECTDIR}/_ext/2142726457/usb_device.d ${OBJECTDIR}/_ext/2142726457/usb_device.p1.d 
 	@${FIXDEPS} ${OBJECTDIR}/_ext/2142726457/usb_device.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
 	
+${OBJECTDIR}/_ext/2142726457/usb_device_cdc.p1: ../framework/usb/src/usb_device_cdc.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/_ext/2142726457" 
+	@${RM} ${OBJECTDIR}/_ext/2142726457/usb_device_cdc.p1.d 
+	@${RM} ${OBJECTDIR}/_ext/2142726457/usb_device_cdc.p1 
+	${MP_CC} --pass1 $(MP_EXTRA_CC_PRE) --chip=$(MP_PROCESSOR_OPTION) -Q -G  -D__DEBUG=1  --debugger=pickit3  --double=24 --float=24 --rom=0-7FF,800-FFF,1000-15FF --opt=+asm,-asmfile,-speed,+space,-debug,-local --addrqual=require --mode=pro -P -N255 -I"." -I"../framework/usb/inc" -I"../bsp/XPRESS" -I"system_config/XPRESS" -I"../framework" -I"../framework/fileio/inc" --warn=0 --asmlist -DXPRJ_XPRESS=$(CND_CONF)  --summary=default,-psect,-class,+mem,+hex,+file --output=default,-inhx032 --runtime=default,+clear,+init,-keep,-no_startup,-osccal,-resetbits,-download,-stackcall,+clib $(COMPARISON_BUILD)  --output=-mcof,+elf:multilocs --stack=compiled:auto:auto "--errformat=%f:%l: error: (%n) %s" "--warnformat=%f:%l: warning: (%n) %s" "--msgformat=%f:%l: advisory: (%n) %s"     -o${OBJECTDIR}/_ext/2142726457/usb_device_cdc.p1 ../framework/usb/src/usb_device_cdc.c 
+	@-${MV} ${OBJECTDIR}/_ext/2142726457/usb_device_cdc.d ${OBJECTDIR}/_ext/2142726457/usb_device_cdc.p1.d 
+	@${FIXDEPS} ${OBJECTDIR}/_ext/2142726457/usb_device_cdc.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
+	
 ${OBJECTDIR}/_ext/2142726457/usb_device_msd.p1: ../framework/usb/src/usb_device_msd.c  nbproject/Makefile-${CND_CONF}.mk
 	@${MKDIR} "${OBJECTDIR}/_ext/2142726457" 
 	@${RM} ${OBJECTDIR}/_ext/2142726457/usb_device_msd.p1.d 
@@ -223,6 +271,14 @@ ${OBJECTDIR}/app_device_msd.p1: app_device_msd.c  nbproject/Makefile-${CND_CONF}
 	@-${MV} ${OBJECTDIR}/app_device_msd.d ${OBJECTDIR}/app_device_msd.p1.d 
 	@${FIXDEPS} ${OBJECTDIR}/app_device_msd.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
 	
+${OBJECTDIR}/app_device_cdc.p1: app_device_cdc.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/app_device_cdc.p1.d 
+	@${RM} ${OBJECTDIR}/app_device_cdc.p1 
+	${MP_CC} --pass1 $(MP_EXTRA_CC_PRE) --chip=$(MP_PROCESSOR_OPTION) -Q -G  --double=24 --float=24 --rom=0-7FF,800-FFF,1000-15FF --opt=+asm,-asmfile,-speed,+space,-debug,-local --addrqual=require --mode=pro -P -N255 -I"." -I"../framework/usb/inc" -I"../bsp/XPRESS" -I"system_config/XPRESS" -I"../framework" -I"../framework/fileio/inc" --warn=0 --asmlist -DXPRJ_XPRESS=$(CND_CONF)  --summary=default,-psect,-class,+mem,+hex,+file --output=default,-inhx032 --runtime=default,+clear,+init,-keep,-no_startup,-osccal,-resetbits,-download,-stackcall,+clib $(COMPARISON_BUILD)  --output=-mcof,+elf:multilocs --stack=compiled:auto:auto "--errformat=%f:%l: error: (%n) %s" "--warnformat=%f:%l: warning: (%n) %s" "--msgformat=%f:%l: advisory: (%n) %s"     -o${OBJECTDIR}/app_device_cdc.p1 app_device_cdc.c 
+	@-${MV} ${OBJECTDIR}/app_device_cdc.d ${OBJECTDIR}/app_device_cdc.p1.d 
+	@${FIXDEPS} ${OBJECTDIR}/app_device_cdc.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
+	
 ${OBJECTDIR}/files.p1: files.c  nbproject/Makefile-${CND_CONF}.mk
 	@${MKDIR} "${OBJECTDIR}" 
 	@${RM} ${OBJECTDIR}/files.p1.d 
@@ -247,6 +303,38 @@ ${OBJECTDIR}/memory.p1: memory.c  nbproject/Makefile-${CND_CONF}.mk
 	@-${MV} ${OBJECTDIR}/memory.d ${OBJECTDIR}/memory.p1.d 
 	@${FIXDEPS} ${OBJECTDIR}/memory.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
 	
+${OBJECTDIR}/stats.p1: stats.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/stats.p1.d 
+	@${RM} ${OBJECTDIR}/stats.p1 
+	${MP_CC} --pass1 $(MP_EXTRA_CC_PRE) --chip=$(MP_PROCESSOR_OPTION) -Q -G  --double=24 --float=24 --rom=0-7FF,800-FFF,1000-15FF --opt=+asm,-asmfile,-speed,+space,-debug,-local --addrqual=require --mode=pro -P -N255 -I"." -I"../framework/usb/inc" -I"../bsp/XPRESS" -I"system_config/XPRESS" -I"../framework" -I"../framework/fileio/inc" --warn=0 --asmlist -DXPRJ_XPRESS=$(CND_CONF)  --summary=default,-psect,-class,+mem,+hex,+file --output=default,-inhx032 --runtime=default,+clear,+init,-keep,-no_startup,-osccal,-resetbits,-download,-stackcall,+clib $(COMPARISON_BUILD)  --output=-mcof,+elf:multilocs --stack=compiled:auto:auto "--errformat=%f:%l: error: (%n) %s" "--warnformat=%f:%l: warning: (%n) %s" "--msgformat=%f:%l: advisory: (%n) %s"     -o${OBJECTDIR}/stats.p1 stats.c 
+	@-${MV} ${OBJECTDIR}/stats.d ${OBJECTDIR}/stats.p1.d 
+	@${FIXDEPS} ${OBJECTDIR}/stats.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
+	
+${OBJECTDIR}/icsp.p1: icsp.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/icsp.p1.d 
+	@${RM} ${OBJECTDIR}/icsp.p1 
+	${MP_CC} --pass1 $(MP_EXTRA_CC_PRE) --chip=$(MP_PROCESSOR_OPTION) -Q -G  --double=24 --float=24 --rom=0-7FF,800-FFF,1000-15FF --opt=+asm,-asmfile,-speed,+space,-debug,-local --addrqual=require --mode=pro -P -N255 -I"." -I"../framework/usb/inc" -I"../bsp/XPRESS" -I"system_config/XPRESS" -I"../framework" -I"../framework/fileio/inc" --warn=0 --asmlist -DXPRJ_XPRESS=$(CND_CONF)  --summary=default,-psect,-class,+mem,+hex,+file --output=default,-inhx032 --runtime=default,+clear,+init,-keep,-no_startup,-osccal,-resetbits,-download,-stackcall,+clib $(COMPARISON_BUILD)  --output=-mcof,+elf:multilocs --stack=compiled:auto:auto "--errformat=%f:%l: error: (%n) %s" "--warnformat=%f:%l: warning: (%n) %s" "--msgformat=%f:%l: advisory: (%n) %s"     -o${OBJECTDIR}/icsp.p1 icsp.c 
+	@-${MV} ${OBJECTDIR}/icsp.d ${OBJECTDIR}/icsp.p1.d 
+	@${FIXDEPS} ${OBJECTDIR}/icsp.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
+	
+${OBJECTDIR}/uart.p1: uart.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/uart.p1.d 
+	@${RM} ${OBJECTDIR}/uart.p1 
+	${MP_CC} --pass1 $(MP_EXTRA_CC_PRE) --chip=$(MP_PROCESSOR_OPTION) -Q -G  --double=24 --float=24 --rom=0-7FF,800-FFF,1000-15FF --opt=+asm,-asmfile,-speed,+space,-debug,-local --addrqual=require --mode=pro -P -N255 -I"." -I"../framework/usb/inc" -I"../bsp/XPRESS" -I"system_config/XPRESS" -I"../framework" -I"../framework/fileio/inc" --warn=0 --asmlist -DXPRJ_XPRESS=$(CND_CONF)  --summary=default,-psect,-class,+mem,+hex,+file --output=default,-inhx032 --runtime=default,+clear,+init,-keep,-no_startup,-osccal,-resetbits,-download,-stackcall,+clib $(COMPARISON_BUILD)  --output=-mcof,+elf:multilocs --stack=compiled:auto:auto "--errformat=%f:%l: error: (%n) %s" "--warnformat=%f:%l: warning: (%n) %s" "--msgformat=%f:%l: advisory: (%n) %s"     -o${OBJECTDIR}/uart.p1 uart.c 
+	@-${MV} ${OBJECTDIR}/uart.d ${OBJECTDIR}/uart.p1.d 
+	@${FIXDEPS} ${OBJECTDIR}/uart.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
+	
+${OBJECTDIR}/stream.p1: stream.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/stream.p1.d 
+	@${RM} ${OBJECTDIR}/stream.p1 
+	${MP_CC} --pass1 $(MP_EXTRA_CC_PRE) --chip=$(MP_PROCESSOR_OPTION) -Q -G  --double=24 --float=24 --rom=0-7FF,800-FFF,1000-15FF --opt=+asm,-asmfile,-speed,+space,-debug,-local --addrqual=require --mode=pro -P -N255 -I"." -I"../framework/usb/inc" -I"../bsp/XPRESS" -I"system_config/XPRESS" -I"../framework" -I"../framework/fileio/inc" --warn=0 --asmlist -DXPRJ_XPRESS=$(CND_CONF)  --summary=default,-psect,-class,+mem,+hex,+file --output=default,-inhx032 --runtime=default,+clear,+init,-keep,-no_startup,-osccal,-resetbits,-download,-stackcall,+clib $(COMPARISON_BUILD)  --output=-mcof,+elf:multilocs --stack=compiled:auto:auto "--errformat=%f:%l: error: (%n) %s" "--warnformat=%f:%l: warning: (%n) %s" "--msgformat=%f:%l: advisory: (%n) %s"     -o${OBJECTDIR}/stream.p1 stream.c 
+	@-${MV} ${OBJECTDIR}/stream.d ${OBJECTDIR}/stream.p1.d 
+	@${FIXDEPS} ${OBJECTDIR}/stream.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
+	
 ${OBJECTDIR}/tmr1.p1: tmr1.c  nbproject/Makefile-${CND_CONF}.mk
 	@${MKDIR} "${OBJECTDIR}" 
 	@${RM} ${OBJECTDIR}/tmr1.p1.d 
@@ -279,6 +367,14 @@ ${OBJECTDIR}/_ext/2142726457/usb_device.p1: ../framework/usb/src/usb_device.c  n
 	@-${MV} ${OBJECTDIR}/_ext/2142726457/usb_device.d ${OBJECTDIR}/_ext/2142726457/usb_device.p1.d 
 	@${FIXDEPS} ${OBJECTDIR}/_ext/2142726457/usb_device.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
 	
+${OBJECTDIR}/_ext/2142726457/usb_device_cdc.p1: ../framework/usb/src/usb_device_cdc.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/_ext/2142726457" 
+	@${RM} ${OBJECTDIR}/_ext/2142726457/usb_device_cdc.p1.d 
+	@${RM} ${OBJECTDIR}/_ext/2142726457/usb_device_cdc.p1 
+	${MP_CC} --pass1 $(MP_EXTRA_CC_PRE) --chip=$(MP_PROCESSOR_OPTION) -Q -G  --double=24 --float=24 --rom=0-7FF,800-FFF,1000-15FF --opt=+asm,-asmfile,-speed,+space,-debug,-local --addrqual=require --mode=pro -P -N255 -I"." -I"../framework/usb/inc" -I"../bsp/XPRESS" -I"system_config/XPRESS" -I"../framework" -I"../framework/fileio/inc" --warn=0 --asmlist -DXPRJ_XPRESS=$(CND_CONF)  --summary=default,-psect,-class,+mem,+hex,+file --output=default,-inhx032 --runtime=default,+clear,+init,-keep,-no_startup,-osccal,-resetbits,-download,-stackcall,+clib $(COMPARISON_BUILD)  --output=-mcof,+elf:multilocs --stack=compiled:auto:auto "--errformat=%f:%l: error: (%n) %s" "--warnformat=%f:%l: warning: (%n) %s" "--msgformat=%f:%l: advisory: (%n) %s"     -o${OBJECTDIR}/_ext/2142726457/usb_device_cdc.p1 ../framework/usb/src/usb_device_cdc.c 
+	@-${MV} ${OBJECTDIR}/_ext/2142726457/usb_device_cdc.d ${OBJECTDIR}/_ext/2142726457/usb_device_cdc.p1.d 
+	@${FIXDEPS} ${OBJECTDIR}/_ext/2142726457/usb_device_cdc.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
+	
 ${OBJECTDIR}/_ext/2142726457/usb_device_msd.p1: ../framework/usb/src/usb_device_msd.c  nbproject/Makefile-${CND_CONF}.mk
 	@${MKDIR} "${OBJECTDIR}/_ext/2142726457" 
 	@${RM} ${OBJECTDIR}/_ext/2142726457/usb_device_msd.p1.d 
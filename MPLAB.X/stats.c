@@ -0,0 +1,53 @@
+/*******************************************************************************
+Copyright 2016 Microchip Technology Inc. (www.microchip.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*******************************************************************************/
+
+#include <string.h>
+#include "stats.h"
+
+STATS stats;
+
+static volatile uint8_t time_high;      // TMR0 overflows, written by the interrupt handler
+
+void STATS_Initialize( void)
+{
+    memset( (void*)&stats, 0, sizeof( stats));
+    // TMR0CS Fosc/4; PSA assigned; PS 1:256 (keep nWPUEN and INTEDG)
+    OPTION_REG = (OPTION_REG & 0xC0) | 0x07;
+    time_high = 0;
+    INTCONbits.TMR0IF = 0;
+    INTCONbits.TMR0IE = 1;
+    INTCONbits.GIE = 1;
+}
+
+uint16_t STATS_Time( void)
+{
+    uint8_t high, low;
+
+    do {                                // TMR0 may overflow between the two reads
+        high = time_high;
+        low = TMR0;
+    } while( high != time_high);
+    return ((uint16_t)high << 8) | low;
+}
+
+void STATS_InterruptHandler( void)
+{
+    if (INTCONbits.TMR0IF) {
+        INTCONbits.TMR0IF = 0;
+        time_high++;
+    }
+}
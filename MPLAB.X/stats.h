@@ -0,0 +1,68 @@
+/*******************************************************************************
+Copyright 2016 Microchip Technology Inc. (www.microchip.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*******************************************************************************/
+
+#ifndef STATS_H
+#define	STATS_H
+
+#include <xc.h>
+#include <stdint.h>
+
+// timestamps from TMR0: Fosc/4 with 1:256 prescaler = 21.33us per tick,
+// extended to 16 bits with its overflows counted by the interrupt handler:
+// wraps every 1.4s, longer than any measured section (a whole MSD sector
+// with its rows, the end of a sequence)
+#define STATS_TIME()                STATS_Time()
+#define STATS_TICKS_PER_MS          47  // 46.875 actually
+
+// accumulate the time elapsed since a timestamp
+#define STATS_ELAPSED( acc, start)  acc += (uint16_t)(STATS_TIME() - (start))
+
+// hot path counters (since power up)
+typedef struct {
+    uint16_t write10;           // WRITE_10 commands
+    uint16_t packets;           // MSD OUT data packets received
+    uint16_t out_waits;         // OUT packets the device had to wait for (host slower)
+    uint16_t in_waits;          // IN packets that found the endpoint still busy
+    uint16_t parse_errors;      // data packets rejected by the HEX parser
+    uint16_t checksum_errors;   // HEX records with a bad checksum
+    uint16_t cdc_packets;       // CDC IN packets sent (UART -> USB)
+    uint16_t cdc_full;          // of which full size, the others flushed by timeout
+    uint32_t cdc_bytes;         // bytes carried by the CDC IN packets
+    uint16_t uart_lost;         // UART bytes dropped: ring full, or receiver overrun (ISR)
+    uint32_t flash_ticks;       // time stalled in flash erase/write
+    uint32_t usb_ticks;         // time spent in USBDeviceTasks()
+    uint32_t msd_ticks;         // time spent in the MSD tasks (sector writes included)
+} STATS;
+
+extern STATS stats;
+
+/**
+ * Clear the counters and start the timestamp timer (TMR0) and its interrupt
+ */
+void STATS_Initialize( void);
+
+/**
+ * Read the 16-bit timestamp (TMR0 and its overflow count)
+ */
+uint16_t STATS_Time( void);
+
+/**
+ * Count the TMR0 overflows, called from the interrupt handler
+ */
+void STATS_InterruptHandler( void);
+
+#endif	/* STATS_H */
@@ -0,0 +1,160 @@
+/*******************************************************************************
+Copyright 2016 Microchip Technology Inc. (www.microchip.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*******************************************************************************/
+
+#include <xc.h>
+#include "usb.h"
+#include "direct.h"
+#include "stream.h"
+
+#define FRAME_SEQ       0
+#define FRAME_CMD       1
+#define FRAME_ADDRESS   2
+#define FRAME_LENGTH    4
+#define FRAME_DATA      STREAM_HEAD
+
+static uint8_t  *frame;         // frame being received, after SYNC (UART ring buffer)
+static uint8_t  pos;            // bytes received, 0 = waiting for SYNC
+static bool     synced;
+static uint8_t  expected;       // sequence number of the next frame
+static bool     nak;            // frames discarded until 'expected' is sent again
+static uint8_t  reply[ STREAM_REPLY_SIZE];
+static bool     reply_ready;
+static uint16_t reply_ms;       // tick of the last reply sent
+static bool     end_pending;    // STREAM_CMD_END programmed, its ACK waits for the verification
+static uint8_t  end_seq;
+
+/**
+ * Update a CRC-16 (CCITT, polynomial 0x1021) with a byte
+ */
+static uint16_t crcByte( uint16_t crc, uint8_t data)
+{
+    uint8_t i;
+
+    crc ^= (uint16_t)data << 8;
+    for( i=0; i < 8; i++)
+        crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    return crc;
+}
+
+static void streamReply( uint8_t code, uint8_t seq, uint8_t arg)
+{
+    reply[ 0] = code;
+    reply[ 1] = seq;
+    reply[ 2] = arg;
+    reply[ 3] = 0;
+    reply_ready = true;
+}
+
+/**
+ * Reject a frame, only the first of a run is reported (then repeated on a 
+ * timer by STREAM_Reply, see STREAM_NAK_REPEAT_MS)
+ */
+static void streamNak( uint8_t reason)
+{
+    if (nak) return;
+    nak = true;
+    streamReply( STREAM_NAK, expected, reason);
+}
+
+/**
+ * Check and execute a complete frame
+ */
+static void streamFrame( void)
+{
+    uint8_t  i;
+    uint8_t  length = frame[ FRAME_LENGTH];
+    uint16_t crc = 0xffff;
+
+    for( i=0; i < FRAME_DATA + length; i++) crc = crcByte( crc, frame[ i]);
+    if ((frame[ i] != (uint8_t)crc) || (frame[ i + 1] != (uint8_t)(crc >> 8))) {
+        streamNak( STREAM_NAK_CRC);
+        return;
+    }
+    if (frame[ FRAME_SEQ] != expected) {
+        streamNak( STREAM_NAK_SEQUENCE);
+        return;
+    }
+    nak = false;
+    switch( frame[ FRAME_CMD]) {
+        case STREAM_CMD_WRITE:
+            DIRECT_StreamWrite( frame[ FRAME_ADDRESS] | ((uint16_t)frame[ FRAME_ADDRESS + 1] << 8),
+                    &frame[ FRAME_DATA], length);
+            streamReply( STREAM_ACK, expected, 0);
+            break;
+        case STREAM_CMD_END:
+            DIRECT_StreamEnd();
+            end_pending = true;
+            end_seq = expected;
+            break;
+        default:
+            streamNak( STREAM_NAK_COMMAND);
+            return;
+    }
+    expected++;
+}
+
+void STREAM_Initialize( uint8_t *buffer)
+{
+    frame = buffer;
+    synced = false;
+    pos = 0;
+    expected = 0;
+    nak = false;
+    reply_ready = false;
+    end_pending = false;
+}
+
+void STREAM_Parse( uint8_t *data, uint8_t count)
+{
+    while( count--) {
+        if (!synced) {                  // skip to the start of a frame
+            synced = (*data++ == STREAM_SYNC);
+            continue;
+        }
+        frame[ pos++] = *data++;
+        if (pos == STREAM_HEAD) {
+            if ((frame[ FRAME_LENGTH] > STREAM_MAX_DATA) || (frame[ FRAME_LENGTH] & 1)) {
+                streamNak( STREAM_NAK_LENGTH);
+                synced = false;
+                pos = 0;
+            }
+        }
+        else if (pos == STREAM_HEAD + frame[ FRAME_LENGTH] + 2) {
+            streamFrame();
+            synced = false;
+            pos = 0;
+        }
+    }
+}
+
+uint8_t STREAM_Reply( uint8_t *buffer)
+{
+    uint8_t i;
+
+    if (end_pending && !DIRECT_ProgrammingInProgress()) {
+        end_pending = false;
+        streamReply( STREAM_ACK, end_seq, direct_stats.result);
+    }
+    // while frames are discarded the reply still holds the NAK
+    if (nak && ((uint16_t)USBGet1msTickCount() - reply_ms >= STREAM_NAK_REPEAT_MS)) 
+        reply_ready = true;
+    if (!reply_ready) return 0;
+    for( i=0; i < STREAM_REPLY_SIZE; i++) buffer[ i] = reply[ i];
+    reply_ready = false;
+    reply_ms = (uint16_t)USBGet1msTickCount();
+    return STREAM_REPLY_SIZE;
+}
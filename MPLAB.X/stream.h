@@ -0,0 +1,88 @@
+/*******************************************************************************
+Copyright 2016 Microchip Technology Inc. (www.microchip.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*******************************************************************************/
+
+#ifndef STREAM_H
+#define	STREAM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*******************************************************************************
+ Binary programming protocol over the CDC data endpoints
+
+ Selected by opening the serial port at CDC_PROG_BAUDRATE (usb_config.h): the
+ OUT data is then parsed as frames instead of being sent to the UART, and the
+ IN endpoint carries the replies. See utilities/xpress-prog.py for the host.
+
+ Frame (host -> device), multi-byte fields little endian:
+    SYNC, seq, cmd, address (2, word address), length, data[length], crc (2)
+ The CRC-16 (CCITT, polynomial 0x1021, seed 0xffff) covers seq .. data.
+ STREAM_CMD_WRITE packs length bytes (even, at most STREAM_MAX_DATA) at the
+ address, using the same row cache as the HEX files; STREAM_CMD_END programs
+ the last rows and verifies the sequence (address and length 0), its ACK is
+ sent once the verification is complete, no frame is read meanwhile.
+
+ Reply (device -> host): code, seq, arg, 0 (reserved)
+    STREAM_ACK  all the frames up to seq were accepted, for STREAM_CMD_END
+                arg is the result (DIRECT_RESULT_xxx, EMPTY if no frame was
+                written since the previous STREAM_CMD_END)
+    STREAM_NAK  frame seq was expected, arg is the reason; the frames that
+                follow are discarded until seq is sent again (go-back-N), 
+                the NAK is repeated every STREAM_NAK_REPEAT_MS meanwhile in 
+                case it was lost
+ Replies are cumulative, the host can keep a window of frames in flight.
+ ******************************************************************************/
+
+#define STREAM_SYNC         0xA5
+#define STREAM_HEAD         5           // seq, cmd, address, length
+#define STREAM_MAX_DATA     64          // one PIC16F1 row
+
+#define STREAM_CMD_WRITE    'W'
+#define STREAM_CMD_END      'E'
+
+#define STREAM_ACK          0x06
+#define STREAM_NAK          0x15
+
+// NAK reasons
+#define STREAM_NAK_CRC      1
+#define STREAM_NAK_SEQUENCE 2
+#define STREAM_NAK_LENGTH   3
+#define STREAM_NAK_COMMAND  4
+
+#define STREAM_REPLY_SIZE   4
+#define STREAM_NAK_REPEAT_MS 100
+
+/**
+ * Reset the parser, the next frame expected is seq 0
+ * @param buffer    frame buffer, STREAM_HEAD + STREAM_MAX_DATA + 2 bytes
+ */
+void STREAM_Initialize( uint8_t *buffer);
+
+/**
+ * Parse a block of data received from the host, programming the frames
+ * completed
+ */
+void STREAM_Parse( uint8_t *data, uint8_t count);
+
+/**
+ * Fetch the reply to send to the host, if any
+ * @param buffer    destination, STREAM_REPLY_SIZE bytes
+ * @return          number of bytes to send, 0 = nothing new
+ */
+uint8_t STREAM_Reply( uint8_t *buffer);
+
+#endif	/* STREAM_H */
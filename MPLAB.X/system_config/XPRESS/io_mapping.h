@@ -52,3 +52,19 @@ limitations under the License.
 //Uncomment this to make the output HEX of this project
 //   to be able to be bootloaded using the HID bootloader
 //#define PROGRAMMABLE_WITH_USB_HID_BOOTLOADER
+
+/** ICSP ***********************************************************/
+//LVP-ICSP connection to the target, when DIRECT_USE_ICSP is defined
+//(RC4/RC5 are taken by the EUSART of the serial bridge)
+#define ICSP_CLK            LATCbits.LATC0
+#define ICSP_CLK_TRIS       TRISCbits.TRISC0
+#define ICSP_DAT            LATCbits.LATC1
+#define ICSP_DAT_TRIS       TRISCbits.TRISC1
+#define ICSP_MCLR           LATAbits.LATA4
+#define ICSP_MCLR_TRIS      TRISAbits.TRISA4
+
+/** BOOT TIMING ****************************************************/
+//Pulsed during the fast boot when SYSTEM_BOOT_TIMING is defined: this is
+//ICSPCLK, not available with DIRECT_USE_ICSP (see system.h)
+#define BOOT_TIMING_PIN     LATCbits.LATC0
+#define BOOT_TIMING_TRIS    TRISCbits.TRISC0
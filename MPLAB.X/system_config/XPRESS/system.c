@@ -23,6 +23,8 @@ limitations under the License.
 #include "usb.h"
 #include "fileio.h"
 #include "direct.h"
+#include "stats.h"
+#include "uart.h"
 
 
 // CONFIG1
@@ -121,21 +123,13 @@ void SYSTEM_Initialize(void)
     #endif
 
     DIRECT_Initialize();
-    USBDeviceInit();	//usb_device.c.  Initializes USB module SFRs and firmware
-    					//variables to known states.
+    STATS_Initialize();
+    //USBDeviceInit() is left to run_usb(), only on the USB path
     //initialise led output
     TRISAbits.TRISA5 = 0;
     APFCONbits.P2SEL = 1;
 
-    //initialise FVR
-    FVRCONbits.FVREN = 1;
-    FVRCONbits.ADFVR = 2;
-    
-    //initialise ADC
-    ADCON0bits.CHS = 0b11111;
-    ADCON1bits.ADCS = 0b110;
-    ADCON1bits.ADFM = 1;
-    ADCON0bits.ADON = 1;
+    //the FVR and the ADC are initialised by the power test in main()
 }
 
 			
@@ -145,5 +139,7 @@ void interrupt SYS_InterruptHigh(void)
     #if defined(USB_INTERRUPT)
         USBDeviceTasks();
     #endif
+    STATS_InterruptHandler();
+    UART_InterruptHandler();
 }
 
@@ -33,6 +33,30 @@ limitations under the License.
 #define MAIN_RETURN void
 #define _XTAL_FREQ 48000000
 
+// program an external PIC16F188xx over LVP-ICSP (pins in io_mapping.h)
+// instead of self-programming the application area
+//#define DIRECT_USE_ICSP
+
+// drive BOOT_TIMING_PIN (io_mapping.h) high from the start of main() to the
+// jump to the application, to measure the boot latency on a scope
+//#define SYSTEM_BOOT_TIMING
+#if defined(SYSTEM_BOOT_TIMING) && defined(DIRECT_USE_ICSP)
+    #error "BOOT_TIMING_PIN is ICSPCLK: SYSTEM_BOOT_TIMING cannot be used with DIRECT_USE_ICSP"
+#endif
+
+// recompute the application CRC on every boot, instead of trusting the commit
+// marker alone (adds a scan of the whole application area to the boot time)
+//#define SYSTEM_BOOT_CRC_CHECK
+
+// once an image has been programmed and verified, detach from USB and start
+// it: the host must have collected the status of the last write and left the
+// drive idle for SYSTEM_AUTO_RUN_MS, the loader then stays detached 
+// SYSTEM_DETACH_MS (the USB stack recommends 80ms at least) before the jump
+// (BOOT_TIMING_PIN is high from the end of file to the jump)
+//#define SYSTEM_AUTO_RUN
+#define SYSTEM_AUTO_RUN_MS  20
+#define SYSTEM_DETACH_MS    100
+
 /*********************************************************************
 * Function: void SYSTEM_Initialize(void)
 *
@@ -0,0 +1,126 @@
+/*******************************************************************************
+Copyright 2016 Microchip Technology Inc. (www.microchip.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*******************************************************************************/
+
+#include <xc.h>
+#include "system.h"
+#include "stats.h"
+#include "uart.h"
+
+static uint8_t          rx_buffer[ UART_RX_SIZE];
+static volatile uint8_t rx_head;        // written by the interrupt handler
+static volatile uint8_t rx_tail;        // written by UART_Read()
+
+static uint8_t          *tx_data;
+static volatile uint8_t tx_count;
+
+void UART_Initialize( void)
+{
+    BAUDCONbits.BRG16 = 1;
+    TXSTA = 0x24;       // TXEN, BRGH, asynchronous 8-bit
+    RCSTA = 0x90;       // SPEN, CREN
+    UART_baudrateSet( 19200);
+    tx_count = 0;
+    UART_RxStart();
+    INTCONbits.PEIE = 1;
+    INTCONbits.GIE = 1;
+}
+
+void UART_baudrateSet( uint32_t baud)
+{
+    uint32_t n = 0xffff;
+
+    if (baud > (_XTAL_FREQ / 4) / 0x10000)
+        n = ((_XTAL_FREQ / 4) + baud / 2) / baud - 1;
+    SPBRGH = (uint8_t)(n >> 8);
+    SPBRGL = (uint8_t)n;
+}
+
+uint8_t *UART_RxStop( void)
+{
+    PIE1bits.RCIE = 0;
+    RCSTAbits.CREN = 0;
+    return rx_buffer;
+}
+
+void UART_RxStart( void)
+{
+    rx_head = rx_tail = 0;
+    RCSTAbits.CREN = 1;
+    PIE1bits.RCIE = 1;
+}
+
+uint8_t UART_RxCount( void)
+{
+    uint8_t head = rx_head;
+
+    if (head < rx_tail) head += UART_RX_SIZE;
+    return head - rx_tail;
+}
+
+uint8_t UART_Read( uint8_t *buffer, uint8_t max)
+{
+    uint8_t count = 0;
+    uint8_t tail = rx_tail;
+
+    while ((count < max) && (tail != rx_head)) {
+        *buffer++ = rx_buffer[ tail];
+        if (++tail == UART_RX_SIZE) tail = 0;
+        count++;
+    }
+    rx_tail = tail;
+    return count;
+}
+
+void UART_Write( uint8_t *buffer, uint8_t count)
+{
+    if (count == 0) return;
+    tx_data = buffer;
+    tx_count = count;
+    PIE1bits.TXIE = 1;
+}
+
+bool UART_TxBusy( void)
+{
+    return tx_count != 0;
+}
+
+void UART_InterruptHandler( void)
+{
+    uint8_t next;
+
+    while (PIE1bits.RCIE && PIR1bits.RCIF) {    // drain the 2 byte FIFO
+        next = rx_head + 1;
+        if (next == UART_RX_SIZE) next = 0;
+        if (next != rx_tail) {
+            rx_buffer[ rx_head] = RCREG;
+            rx_head = next;
+        }
+        else {
+            next = RCREG;                   // ring full, byte dropped
+            stats.uart_lost++;
+        }
+    }
+    if (RCSTAbits.OERR && PIE1bits.RCIE) {                   // restart the receiver after an overrun
+        stats.uart_lost++;                  // at least one byte, the FIFO was full
+        RCSTAbits.CREN = 0;
+        RCSTAbits.CREN = 1;
+    }
+    if (PIE1bits.TXIE && PIR1bits.TXIF) {
+        TXREG = *tx_data++;
+        if (--tx_count == 0) PIE1bits.TXIE = 0;
+    }
+}
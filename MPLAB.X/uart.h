@@ -0,0 +1,86 @@
+/*******************************************************************************
+Copyright 2016 Microchip Technology Inc. (www.microchip.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*******************************************************************************/
+
+#ifndef UART_H
+#define	UART_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*******************************************************************************
+ Interrupt driven EUSART (RC4 = TX, RC5 = RX)
+
+ Received bytes are queued in a ring buffer by the interrupt handler, bytes to
+ transmit are fed to the UART from the caller's buffer, so the main loop only
+ moves whole blocks between the UART and the CDC endpoints.
+ ******************************************************************************/
+
+#define UART_RX_SIZE    72      // receive ring buffer, holds two CDC packets, or
+                                // a stream frame while the receiver is stopped
+
+/**
+ * Configure the EUSART (8N1, 19200 baud) and enable its interrupts
+ */
+void UART_Initialize( void);
+
+/**
+ * Set the baud rate (Fosc/4 based, 16-bit generator: 184 baud .. 3 Mbaud)
+ */
+void UART_baudrateSet( uint32_t baud);
+
+/**
+ * Stop the receiver and discard the bytes waiting, the ring buffer is lent
+ * to the caller until UART_RxStart()
+ * @return  the ring buffer, UART_RX_SIZE bytes
+ */
+uint8_t *UART_RxStop( void);
+
+/**
+ * Restart the receiver, with an empty ring buffer
+ */
+void UART_RxStart( void);
+
+/**
+ * @return  number of received bytes waiting in the ring buffer
+ */
+uint8_t UART_RxCount( void);
+
+/**
+ * Move received bytes out of the ring buffer
+ * @param buffer    destination
+ * @param max       size of the destination
+ * @return          number of bytes copied
+ */
+uint8_t UART_Read( uint8_t *buffer, uint8_t max);
+
+/**
+ * Start transmitting a block, in the background
+ * The buffer must not be modified until UART_TxBusy() returns false.
+ */
+void UART_Write( uint8_t *buffer, uint8_t count);
+
+/**
+ * @return  true while a block is being transmitted
+ */
+bool UART_TxBusy( void);
+
+/**
+ * EUSART receive/transmit interrupt service, called from the ISR
+ */
+void UART_InterruptHandler( void);
+
+#endif	/* UART_H */
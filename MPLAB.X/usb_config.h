@@ -24,6 +24,8 @@ limitations under the License.
 
 /** DEFINITIONS ****************************************************/
 #define USB_EP0_BUFF_SIZE		8	// Valid Options: 8, 16, 32, or 64 bytes.
+								// 8: the setup and data buffers take 16 bytes
+								// of the 1 KB RAM instead of 128
 								// Using larger options take more SRAM, but
 								// does not provide much advantage in most types
 								// of applications.  Exceptions to this, are applications
@@ -165,6 +167,29 @@ limitations under the License.
 #define MAX_LUN                 0u   //Includes 0 (ex: 0 = 1 LUN, 1 = 2 LUN, etc.)
 #define MSD_DATA_IN_EP          1u
 #define MSD_DATA_OUT_EP         1u
+#define MSD_WRITE_READY         DIRECT_WriteReady   // data OUT flow control (direct.c)
+
+/* CDC */
+#define CDC_COMM_INTF_ID        0x01
+#define CDC_COMM_EP             2u
+#define CDC_COMM_IN_EP_SIZE     10u
+#define CDC_DATA_INTF_ID        0x02
+#define CDC_DATA_EP             3u
+#define CDC_DATA_OUT_EP_SIZE    32u     // the OUT buffer is sent to the UART in place
+#define CDC_DATA_IN_EP_SIZE     32u
+// UART -> USB aggregation: a packet is sent when CDC_DATA_IN_EP_SIZE bytes
+// are waiting, or when the oldest byte has waited CDC_IN_FLUSH_MS (1..255ms,
+// 0 = send as soon as possible, lowest latency)
+#ifndef CDC_IN_FLUSH_MS
+#define CDC_IN_FLUSH_MS         2u
+#endif
+// opening the port at this rate selects the binary programming protocol
+// (stream.h) instead of the serial bridge, comment out to remove it
+#define CDC_PROG_BAUDRATE       600UL
+
+//Set_Line_Coding, Set_Control_Line_State, Get_Line_Coding, and Serial_State commands
+#define USB_CDC_SUPPORT_ABSTRACT_CONTROL_MANAGEMENT_CAPABILITIES_D1
+#define USB_CDC_SET_LINE_CODING_HANDLER APP_SetLineCodingHandler
 
 /** DEFINITIONS ****************************************************/
 
@@ -30,6 +30,7 @@ limitations under the License.
 /** INCLUDES *******************************************************/
 #include "usb.h"
 #include "usb_device_msd.h"
+#include "usb_device_cdc.h"
 
 /** CONSTANTS ******************************************************/
 
@@ -39,13 +40,13 @@ const USB_DEVICE_DESCRIPTOR device_dsc=
     0x12,    // Size of this descriptor in bytes
     USB_DESCRIPTOR_DEVICE,                // DEVICE descriptor type
     0x0200,                 // USB Spec Release Number in BCD format
-    0x00,                   // See interface for class codes
-    0x00,                   // Subclass code
-    0x00,                   // Protocol code
+    0xEF,                   // Miscellaneous device class (composite with IAD)
+    0x02,                   // Common class subclass code
+    0x01,                   // Interface Association Descriptor protocol code
     USB_EP0_BUFF_SIZE,      // Max packet size for EP0, see usb_config.h
     0x04D8,                 // Vendor ID  "Microchip Technology Inc"
     0x0009,                 // MSD device
-    0x0001,                 // Device release number in BCD format
+    0x0002,                 // Device release number in BCD format (composite)
     0x01,                   // Manufacturer string index
     0x02,                   // Product string index
     0x03,                   // Device serial number string index
@@ -57,8 +58,8 @@ const uint8_t configDescriptor1[]={
     /* Configuration Descriptor */
     9,    // Size of this descriptor in bytes
     USB_DESCRIPTOR_CONFIGURATION,                // CONFIGURATION descriptor type
-    32, 0,                  // Total length of data for this cfg
-    1,                      // Number of interfaces in this cfg
+    98, 0,                  // Total length of data for this cfg
+    3,                      // Number of interfaces in this cfg
     1,                      // Index value of this configuration
     2,                      // Configuration string index
     _DEFAULT | _SELF,       // Attributes, see usb_device.h
@@ -90,6 +91,86 @@ const uint8_t configDescriptor1[]={
     _BULK,
     MSD_OUT_EP_SIZE,0x00,
     0x01,    
+
+//---------------CDC Function 1 Descriptors------------------------
+    /* Interface Association Descriptor */
+    8,                      // Size of this descriptor in bytes
+    0x0B,                   // INTERFACE ASSOCIATION descriptor type
+    CDC_COMM_INTF_ID,       // First associated interface
+    2,                      // Number of contiguous associated interfaces
+    COMM_INTF,              // Class code
+    ABSTRACT_CONTROL_MODEL, // Subclass code
+    V25TER,                 // Protocol code
+    0,                      // Function string index
+
+    /* Interface Descriptor */
+    9,
+    USB_DESCRIPTOR_INTERFACE,
+    CDC_COMM_INTF_ID,       // Interface Number
+    0,                      // Alternate Setting Number
+    1,                      // Number of endpoints in this intf
+    COMM_INTF,              // Class code
+    ABSTRACT_CONTROL_MODEL, // Subclass code
+    V25TER,                 // Protocol code
+    0,                      // Interface string index
+
+    /* CDC Class-Specific Descriptors */
+    sizeof(USB_CDC_HEADER_FN_DSC),
+    CS_INTERFACE,
+    DSC_FN_HEADER,
+    0x10,0x01,
+
+    sizeof(USB_CDC_ACM_FN_DSC),
+    CS_INTERFACE,
+    DSC_FN_ACM,
+    USB_CDC_ACM_FN_DSC_VAL,
+
+    sizeof(USB_CDC_UNION_FN_DSC),
+    CS_INTERFACE,
+    DSC_FN_UNION,
+    CDC_COMM_INTF_ID,
+    CDC_DATA_INTF_ID,
+
+    sizeof(USB_CDC_CALL_MGT_FN_DSC),
+    CS_INTERFACE,
+    DSC_FN_CALL_MGT,
+    0x00,
+    CDC_DATA_INTF_ID,
+
+    /* Endpoint Descriptor */
+    7,
+    USB_DESCRIPTOR_ENDPOINT,
+    _EP02_IN,
+    _INTERRUPT,
+    CDC_COMM_IN_EP_SIZE,0x00,
+    0x02,
+
+    /* Interface Descriptor */
+    9,
+    USB_DESCRIPTOR_INTERFACE,
+    CDC_DATA_INTF_ID,       // Interface Number
+    0,                      // Alternate Setting Number
+    2,                      // Number of endpoints in this intf
+    DATA_INTF,              // Class code
+    0,                      // Subclass code
+    NO_PROTOCOL,            // Protocol code
+    0,                      // Interface string index
+
+    /* Endpoint Descriptor */
+    7,
+    USB_DESCRIPTOR_ENDPOINT,
+    _EP03_OUT,
+    _BULK,
+    CDC_DATA_OUT_EP_SIZE,0x00,
+    0x00,
+
+    /* Endpoint Descriptor */
+    7,
+    USB_DESCRIPTOR_ENDPOINT,
+    _EP03_IN,
+    _BULK,
+    CDC_DATA_IN_EP_SIZE,0x00,
+    0x00,
 };
 
 
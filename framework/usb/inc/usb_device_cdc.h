@@ -392,6 +392,44 @@ please contact mla_licensing@microchip.com
  *****************************************************************************/
 #define USBUSARTIsTxTrfReady()      (cdc_trf_state == CDC_TX_READY)
 
+/******************************************************************************
+    Function:
+        uint8_t* USBUSARTTxBuffer(void)
+        
+    Summary:
+        This macro returns the CDC bulk IN endpoint buffer.
+
+    Description:
+        This macro returns the buffer the CDC class handler firmware sends
+        from, CDC_DATA_IN_EP_SIZE bytes.  While USBUSARTIsTxTrfReady() is
+        true it is not in use: the application can build the next packet in
+        place and send it with putUSBUSART() (which then copies it onto
+        itself), instead of keeping a buffer of its own.
+
+        Typical Usage:
+        <code>
+            if(USBUSARTIsTxTrfReady())
+            {
+                n = UART_Read(USBUSARTTxBuffer(), CDC_DATA_IN_EP_SIZE);
+                putUSBUSART(USBUSARTTxBuffer(), n);
+            }
+        </code>
+        
+    PreCondition:
+        USBUSARTIsTxTrfReady() returns true
+        
+    Parameters:
+        None
+        
+    Return Values:
+        Pointer to the bulk IN endpoint buffer
+        
+    Remarks:
+        None
+  
+ *****************************************************************************/
+#define USBUSARTTxBuffer()          ((uint8_t*)cdc_data_tx)
+
 /******************************************************************************
     Function:
         void mUSBUSARTTxRam(uint8_t *pData, uint8_t len)
@@ -652,6 +690,49 @@ bool USBCDCEventHandler(USB_EVENT event, void *pdata, uint16_t size);
   **********************************************************************************/
 uint8_t getsUSBUSART(uint8_t *buffer, uint8_t len);
 
+/**********************************************************************************
+  Function:
+        uint8_t peekUSBUSART(void)
+
+  Summary:
+    In place version of getsUSBUSART(): returns the number of BYTEs received
+    in the CDC Bulk OUT endpoint buffer (USBUSARTRxBuffer()), 0 if none.  The
+    endpoint is not re-armed, further packets are NAK'd until
+    releaseUSBUSART() is called, so the application can use the packet
+    without keeping a copy of its own.
+
+    Typical Usage:
+    <code>
+        if((numBytes = peekUSBUSART()) \> 0)
+        {
+            ProcessData(USBUSARTRxBuffer(), numBytes);
+            releaseUSBUSART();
+        }
+    </code>
+  **********************************************************************************/
+uint8_t peekUSBUSART(void);
+
+/**********************************************************************************
+  Function:
+        void releaseUSBUSART(void)
+
+  Summary:
+    Re-arms the CDC Bulk OUT endpoint, once the packet returned by
+    peekUSBUSART() (non-zero length) has been used.
+  **********************************************************************************/
+void releaseUSBUSART(void);
+
+/******************************************************************************
+    Function:
+        uint8_t* USBUSARTRxBuffer(void)
+
+    Summary:
+        This macro returns the CDC bulk OUT endpoint buffer,
+        CDC_DATA_OUT_EP_SIZE bytes, valid after peekUSBUSART() returned a
+        non-zero length and until releaseUSBUSART().
+ *****************************************************************************/
+#define USBUSARTRxBuffer()          ((uint8_t*)cdc_data_rx)
+
 /******************************************************************************
   Function:
 	void putUSBUSART(char *data, uint8_t length)
@@ -950,6 +1031,8 @@ extern uint8_t cdc_mem_type;
 
 extern CDC_NOTICE cdc_notice;
 extern LINE_CODING line_coding;
+extern volatile unsigned char cdc_data_tx[CDC_DATA_IN_EP_SIZE];
+extern volatile unsigned char cdc_data_rx[CDC_DATA_OUT_EP_SIZE];
 
 extern volatile CTRL_TRF_SETUP SetupPkt;
 extern const uint8_t configDescriptor1[];
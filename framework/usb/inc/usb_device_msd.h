@@ -93,6 +93,11 @@ please contact mla_licensing@microchip.com
     #define MSD_TEST_UNIT_READY             	0x00
     #define MSD_VERIFY                         	0x2f
     #define MSD_STOP_START                     	0x1b
+    #define MSD_SYNCHRONIZE_CACHE           	0x35
+
+    /* MODE_SENSE page codes */
+    #define MSD_MODE_PAGE_CACHING               0x08
+    #define MSD_MODE_PAGE_ALL                   0x3F
     
     #define MSD_READ10_WAIT                     0x00
     #define MSD_READ10_BLOCK                    0x01
@@ -1610,12 +1610,6 @@ static void USBConfigureEndpoint(uint8_t EPNum, uint8_t direction)
  *****************************************************************************/
 static void USBCtrlEPServiceComplete(void)
 {
-    /*
-     * PKTDIS bit is set when a Setup Transaction is received.
-     * Clear to resume packet processing.
-     */
-    USBPacketDisable = 0;
-
 	//Check the busy bits and the SetupPtk.DataDir variables to determine what type of
 	//control transfer is currently in progress.  We need to know the type of control
 	//transfer that is currently pending, in order to know how to properly arm the 
@@ -1740,6 +1734,14 @@ static void USBCtrlEPServiceComplete(void)
 
     }//end if(ctrl_trf_session_owner == MUID_NULL)
 
+    /*
+     * PKTDIS bit is set when a Setup Transaction is received.
+     * Clear to resume packet processing, only now that the data and status
+     * stages are armed: the first IN/OUT token of the host is then served
+     * at once, instead of being NAK'd and retried in a later frame.
+     */
+    USBPacketDisable = 0;
+
 }//end USBCtrlEPServiceComplete
 
 
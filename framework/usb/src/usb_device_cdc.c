@@ -92,7 +92,6 @@ USB_HANDLE CDCDataInHandle;
 
 
 CONTROL_SIGNAL_BITMAP control_signal_bitmap;
-uint32_t BaudRateGen;			// BRG value calculated from baud rate
 
 #if defined(USB_CDC_SUPPORT_DSR_REPORTING)
     BM_SERIAL_STATE SerialStateBitmap;
@@ -107,7 +106,7 @@ uint32_t BaudRateGen;			// BRG value calculated from baud rate
   used for conformance.
  **************************************************************************/
 #define dummy_length    0x08
-uint8_t dummy_encapsulated_cmd_response[dummy_length];
+const uint8_t dummy_encapsulated_cmd_response[dummy_length] = {0};  // program memory, saves RAM
 
 #if defined(USB_CDC_SET_LINE_CODING_HANDLER)
 CTRL_TRF_RETURN USB_CDC_SET_LINE_CODING_HANDLER(CTRL_TRF_PARAMS);
@@ -168,14 +167,15 @@ void USBCheckCDCRequest(void)
         //****** These commands are required ******//
         case SEND_ENCAPSULATED_COMMAND:
          //send the packet
-            inPipes[0].pSrc.bRam = (uint8_t*)&dummy_encapsulated_cmd_response;
+            inPipes[0].pSrc.bRom = dummy_encapsulated_cmd_response;
             inPipes[0].wCount.Val = dummy_length;
-            inPipes[0].info.bits.ctrl_trf_mem = USB_EP0_RAM;
+            inPipes[0].info.bits.ctrl_trf_mem = USB_EP0_ROM;
             inPipes[0].info.bits.busy = 1;
             break;
         case GET_ENCAPSULATED_RESPONSE:
             // Populate dummy_encapsulated_cmd_response first.
-            inPipes[0].pSrc.bRam = (uint8_t*)&dummy_encapsulated_cmd_response;
+            inPipes[0].pSrc.bRom = dummy_encapsulated_cmd_response;
+            inPipes[0].info.bits.ctrl_trf_mem = USB_EP0_ROM;
             inPipes[0].info.bits.busy = 1;
             break;
         //****** End of required commands ******//
@@ -513,6 +513,50 @@ uint8_t getsUSBUSART(uint8_t *buffer, uint8_t len)
     
 }//end getsUSBUSART
 
+/**********************************************************************************
+  Function:
+        uint8_t peekUSBUSART(void)
+
+  Summary:
+    Returns the number of BYTEs received through the CDC Bulk OUT endpoint,
+    left in the endpoint buffer (USBUSARTRxBuffer()) until releaseUSBUSART().
+
+  Description:
+    peekUSBUSART is the in place version of getsUSBUSART(): the packet is
+    not copied, and further packets are NAK'd until releaseUSBUSART() has
+    been called.  An empty packet is released here.
+
+  Output:
+    uint8_t -    number of BYTEs in USBUSARTRxBuffer(), 0 if no packet has
+                 been received
+  **********************************************************************************/
+uint8_t peekUSBUSART(void)
+{
+    if(USBHandleBusy(CDCDataOutHandle))
+        return 0;
+
+    if(USBHandleGetLength(CDCDataOutHandle) == 0)
+        releaseUSBUSART();
+
+    return USBHandleGetLength(CDCDataOutHandle);
+}//end peekUSBUSART
+
+/**********************************************************************************
+  Function:
+        void releaseUSBUSART(void)
+
+  Summary:
+    Re-arms the CDC Bulk OUT endpoint once the packet returned by
+    peekUSBUSART() has been used.
+
+  Conditions:
+    peekUSBUSART() returned a non-zero length since the previous call.
+  **********************************************************************************/
+void releaseUSBUSART(void)
+{
+    CDCDataOutHandle = USBRxOnePacket(CDC_DATA_EP,(uint8_t*)&cdc_data_rx,sizeof(cdc_data_rx));
+}//end releaseUSBUSART
+
 /******************************************************************************
   Function:
 	void putUSBUSART(char *data, uint8_t length)
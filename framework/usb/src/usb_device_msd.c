@@ -25,6 +25,7 @@ please contact mla_licensing@microchip.com
 #include "system_config.h"
 
 #include <usb_device_msd.h>
+#include "stats.h"
 
 #ifdef USB_USE_MSD
 
@@ -34,7 +35,7 @@ please contact mla_licensing@microchip.com
     #define LUN_INDEX gblCBW.bCBWLUN
 #endif
 
-extern LUN_FUNCTIONS LUN[MAX_LUN + 1];
+extern const LUN_FUNCTIONS LUN[MAX_LUN + 1];
 #define LUNMediaInitialize()                LUN[LUN_INDEX].MediaInitialize(LUN[LUN_INDEX].mediaParameters)
 #define LUNReadCapacity()                   LUN[LUN_INDEX].ReadCapacity(LUN[LUN_INDEX].mediaParameters)
 #define LUNReadSectorSize()                 LUN[LUN_INDEX].ReadSectorSize(LUN[LUN_INDEX].mediaParameters)
@@ -42,6 +43,14 @@ extern LUN_FUNCTIONS LUN[MAX_LUN + 1];
 #define LUNSectorWrite(bLBA,pDest,seg)      LUN[LUN_INDEX].SectorWrite(LUN[LUN_INDEX].mediaParameters, bLBA, pDest, seg)
 #define LUNWriteProtectState()              LUN[LUN_INDEX].WriteProtectState(LUN[LUN_INDEX].mediaParameters)
 #define LUNSectorRead(bLBA,pSrc,seg)        LUN[LUN_INDEX].SectorRead(LUN[LUN_INDEX].mediaParameters, bLBA, pSrc, seg)
+//Optional flow control of the data OUT phase: a packet received is only 
+//processed (and the next one armed) once the media can take it
+#if defined(MSD_WRITE_READY)
+    extern bool MSD_WRITE_READY(void);
+    #define LUNWriteReady()                 MSD_WRITE_READY()
+#else
+    #define LUNWriteReady()                 true
+#endif
 
 //Adjustable user options
 #define MSD_FAILED_READ_MAX_ATTEMPTS  (uint8_t)1u    //Used for error case handling
@@ -78,10 +87,11 @@ uint8_t MSDReadState;
 uint8_t MSDWriteState;
 uint8_t MSDRetryAttempt;
 //Other variables
-USB_MSD_CBW gblCBW;	
+//The command is used in place: msd_cbw is only re-armed once its CSW has been
+//sent (or on a reset), the data phase uses msd_buffer
+#define gblCBW (*(USB_MSD_CBW*)&msd_cbw)
 uint8_t gblCBWLength;
 RequestSenseResponse gblSenseData[MAX_LUN + 1];
-uint8_t *ptrNextData;
 USB_HANDLE USBMSDOutHandle;
 USB_HANDLE USBMSDInHandle;
 uint16_t MSBBufferIndex;
@@ -89,6 +99,9 @@ uint16_t gblMediaPresent;
 bool SoftDetach[MAX_LUN + 1];
 bool MSDHostNoData;
 bool MSDCBWValid;
+static bool MSDOutArmed;    // next OUT packet already armed (into msd_buffer)
+static bool MSDOutWaited;   // current OUT packet had not arrived yet (stats)
+static bool MSDInWaited;    // IN endpoint was still busy (stats)
 
 static USB_MSD_TRANSFER_LENGTH TransferLength;
 static USB_MSD_LBA LBA;
@@ -161,6 +174,7 @@ void USBMSDInit(void)
     MSDReadState = MSD_READ10_WAIT;
     MSDWriteState = MSD_WRITE10_WAIT;
     MSDHostNoData = false;
+    MSDOutArmed = false;
     gblNumBLKS.Val = 0;
     gblBLKLen.Val = 0;
     MSDCBWValid = true;
@@ -259,6 +273,7 @@ void USBCheckMSDRequest(void)
             MSDReadState = MSD_READ10_WAIT;
             MSDWriteState = MSD_WRITE10_WAIT;
             MSDCBWValid = true;
+            MSDOutArmed = false;
             //Need to re-arm MSD bulk OUT endpoint, if it isn't currently armed,
             //to be able to receive next CBW.  If it is already armed, don't need
             //to do anything, since we can already receive the next CBW (or we are
@@ -374,15 +389,8 @@ uint8_t MSDTasks(void)
             {
                 //If we are in the MSD_WAIT state, and we received an OUT transaction
                 //on the MSD OUT endpoint, then we must have just received an MSD
-                //Command Block Wrapper (CBW).
-                //First copy the the received data to to the gblCBW structure, so
-                //that we keep track of the command, but free up the MSD OUT endpoint
-                //buffer for fulfilling whatever request may have been received.
-                //gblCBW = msd_cbw; //we are doing this, but below method can yield smaller code size
-                for(i = 0; i < MSD_CBW_SIZE; i++)
-                {
-                    *((uint8_t*)&gblCBW.dCBWSignature + i) = *((uint8_t*)&msd_cbw.dCBWSignature + i);
-                }
+                //Command Block Wrapper (CBW).  It stays in msd_cbw (gblCBW) until
+                //the CSW: the data phase is received into msd_buffer.
 
                 //If this CBW is valid?
                 if((USBHandleGetLength(USBMSDOutHandle) == MSD_CBW_SIZE) && (gblCBW.dCBWSignature == MSD_VALID_CBW_SIGNATURE))
@@ -837,27 +845,80 @@ void MSDProcessCommandMediaPresent(void)
             MSDCommandState = MSD_COMMAND_RESPONSE;
             break;
             
+        case MSD_READ_FORMAT_CAPACITY:
+        {
+            //Windows asks for this before READ_CAPACITY.  The response is a
+            //capacity list header and the current capacity descriptor (block
+            //count, descriptor type "formatted media", block length), big endian.
+            USB_MSD_SECTOR_SIZE sectorSize;
+            USB_MSD_CAPACITY capacity;
+
+            if(MSDHostNoData == true)
+            {
+                MSDCommandState = MSD_COMMAND_WAIT;
+                break;
+            }
+            capacity.Val = LUNReadCapacity() + 1;   //number of blocks, not last LBA
+            sectorSize.Val = LUNReadSectorSize();
+
+            msd_buffer[0]=0x00;
+            msd_buffer[1]=0x00;
+            msd_buffer[2]=0x00;
+            msd_buffer[3]=0x08;             //capacity list length, one descriptor
+            msd_buffer[4]=capacity.v[3];
+            msd_buffer[5]=capacity.v[2];
+            msd_buffer[6]=capacity.v[1];
+            msd_buffer[7]=capacity.v[0];
+            msd_buffer[8]=0x02;             //formatted media
+            msd_buffer[9]=sectorSize.v[2];
+            msd_buffer[10]=sectorSize.v[1];
+            msd_buffer[11]=sectorSize.v[0];
+
+            //Allocation length, big endian
+            TransferLength.byte.HB = gblCBW.CBWCB[7];
+            TransferLength.byte.LB = gblCBW.CBWCB[8];
+            MSDComputeDeviceInAndResidue(12);
+            MSDCommandState = MSD_COMMAND_RESPONSE;
+            break;
+        }
+
         case MSD_MODE_SENSE:
-            msd_buffer[0]=0x03;
+            //Mode parameter header: mode data length, medium type, device
+            //specific parameter (write protect), block descriptor length.
+            //The caching page is appended when it is asked for (alone or with
+            //all the pages), otherwise hosts fall back to guessing the cache
+            //type with more MODE_SENSE attempts.  All its bits are 0: write
+            //through (WCE = 0), read cache enabled, so no SYNCHRONIZE_CACHE is
+            //needed after the writes; page control "changeable values" gets
+            //the same zeros, nothing can be changed.
+            if(MSDHostNoData == true)
+            {
+                MSDCommandState = MSD_COMMAND_WAIT;
+                break;
+            }
+            NumBytesInPacket = 4;
+            i = gblCBW.CBWCB[2] & 0x3F;     //page code
+            if((i == MSD_MODE_PAGE_CACHING) || (i == MSD_MODE_PAGE_ALL))
+            {
+                NumBytesInPacket = 4 + 20;
+                for(i = 4; i < NumBytesInPacket; i++)
+                {
+                    msd_buffer[i] = 0x00;
+                }
+                msd_buffer[4]=MSD_MODE_PAGE_CACHING;
+                msd_buffer[5]=0x12;         //page length
+            }
+            msd_buffer[0]=NumBytesInPacket - 1;
             msd_buffer[1]=0x00;
             msd_buffer[2]=(LUNWriteProtectState()) ? 0x80 : 0x00;
             msd_buffer[3]= 0x00;
 
             //Compute and load proper csw residue and device in number of byte.
-            TransferLength.Val = 0x04;
-            MSDComputeDeviceInAndResidue(0x04);
+            TransferLength.Val = gblCBW.CBWCB[4];   //allocation length
+            MSDComputeDeviceInAndResidue(NumBytesInPacket);
             MSDCommandState = MSD_COMMAND_RESPONSE;
     	    break;
 
-        case MSD_PREVENT_ALLOW_MEDIUM_REMOVAL:
-            gblSenseData[LUN_INDEX].SenseKey=S_ILLEGAL_REQUEST;
-            gblSenseData[LUN_INDEX].ASC=ASC_INVALID_COMMAND_OPCODE;
-            gblSenseData[LUN_INDEX].ASCQ=ASCQ_INVALID_COMMAND_OPCODE;
-            msd_csw.bCSWStatus = MSD_CSW_COMMAND_FAILED;
-            msd_csw.dCSWDataResidue = 0x00;
-            MSDCommandState = MSD_COMMAND_WAIT;
-            break;
-
         case MSD_TEST_UNIT_READY:
             //The host will typically send this command periodically to check if
             //it is ready to be used and to obtain polled notification of changes
@@ -887,6 +948,12 @@ void MSDProcessCommandMediaPresent(void)
             }
             break;
 
+        case MSD_PREVENT_ALLOW_MEDIUM_REMOVAL:
+            //There is nothing to lock, the files are handled as they arrive.
+            //Failing it costs a REQUEST_SENSE at every mount and unmount.
+        case MSD_SYNCHRONIZE_CACHE:
+            //The writes are not cached (see MODE_SENSE), nothing to flush.
+            //Hosts that skip the caching page may still send it on fsync().
         case MSD_VERIFY:
         //Fall through to STOP_START
             
@@ -1073,16 +1140,9 @@ uint8_t MSDReadHandler(void)
             //Fall through to MSD_READ10_SECTOR
             
         case MSD_READ10_SECTOR:
-            //if the old data isn't completely sent yet
-            if(USBHandleBusy(USBMSDInHandle) != 0)
-            {
-                break;
-            }
-            
             LBA.Val++;
             msd_csw.dCSWDataResidue=BLOCKLEN_512;//in order to send the 512 bytes of data read
             segment = 0;    // !!!
-            ptrNextData=(uint8_t *)&msd_buffer[0];
             
             MSDReadState = MSD_READ10_TX_SECTOR;
             //Fall through to MSD_READ10_TX_SECTOR
@@ -1100,11 +1160,18 @@ uint8_t MSDReadHandler(void)
         case MSD_READ10_TX_PACKET:
             /* Write next chunk of data to EP Buffer and send */
             
-            //Make sure the endpoint is available before using it.
+            //Make sure the previous packet has been sent, before building the
+            //next one in its buffer
             if(USBHandleBusy(USBMSDInHandle))
             {
+                MSDInWaited = true;
                 break;
             }
+            if(MSDInWaited)
+            {
+                stats.in_waits++;
+                MSDInWaited = false;
+            }
             
             // get directly a packet of data from target !!!
             if(LUNSectorRead(LBA.Val, (uint8_t*)&msd_buffer[0], segment++) != true)
@@ -1126,13 +1193,12 @@ uint8_t MSDReadHandler(void)
             }//else we successfully read a packet worth of data from our media
             
             //Prepare the USB module to send an IN transaction worth of data to the host.
-            USBMSDInHandle = USBTxOnePacket(MSD_DATA_IN_EP,ptrNextData,MSD_IN_EP_SIZE);
+            USBMSDInHandle = USBTxOnePacket(MSD_DATA_IN_EP,(uint8_t*)&msd_buffer[0],MSD_IN_EP_SIZE);
             
             MSDReadState = MSD_READ10_TX_SECTOR;
 
             gblCBW.dCBWDataTransferLength-=	MSD_IN_EP_SIZE;
             msd_csw.dCSWDataResidue-=MSD_IN_EP_SIZE;
-//            ptrNextData+=MSD_IN_EP_SIZE;  // keep the pointer fix!!!
             break;
         
         default:
@@ -1174,7 +1240,7 @@ uint8_t MSDReadHandler(void)
  *****************************************************************************/
 uint8_t MSDWriteHandler(void)
 {
-    static uint8_t segment;
+    static uint16_t packet;
     
     switch(MSDWriteState)
     {
@@ -1216,61 +1282,61 @@ uint8_t MSDWriteHandler(void)
                 MSDWriteState = MSD_WRITE10_WAIT;
                 return MSDWriteState;
             }
+            MSDOutArmed = false;
+            stats.write10++;
+
+            //The whole transfer is received as one continuous run of packets,
+            //a single counter gives both the sector (LBA) and the segment 
+            //within it, the residue covers all the sectors
+            packet = 0;
+            msd_csw.dCSWDataResidue = TransferLength.Val * (uint32_t)FILEIO_CONFIG_MEDIA_SECTOR_SIZE;
         	
-            MSD_State = MSD_WRITE10_BLOCK;
+            MSDWriteState = MSD_WRITE10_BLOCK;
             //Fall through to MSD_WRITE10_BLOCK
             
         case MSD_WRITE10_BLOCK:
-            if(TransferLength.Val == 0)
+            if(msd_csw.dCSWDataResidue == 0)
             {
                 MSDWriteState = MSD_WRITE10_WAIT;
                 break;
             }
             
-            MSDWriteState = MSD_WRITE10_RX_SECTOR;
-            ptrNextData=(uint8_t *)&msd_buffer[0];
-              
-            msd_csw.dCSWDataResidue=BLOCKLEN_512;
-            segment = 0;    // !!!
-        	
-            //Fall through to MSD_WRITE10_RX_SECTOR
-        case MSD_WRITE10_RX_SECTOR:
-        {
-            if(msd_csw.dCSWDataResidue>0)
+            //Arm the first packet (all the following ones are armed as soon
+            //as the previous one has been written)
+            if(MSDOutArmed == false)
             {
                 if(USBHandleBusy(USBMSDOutHandle) == true) break;
-                USBMSDOutHandle = USBRxOnePacket(MSD_DATA_OUT_EP,ptrNextData,MSD_OUT_EP_SIZE);
+                USBMSDOutHandle = USBRxOnePacket(MSD_DATA_OUT_EP,(uint8_t*)&msd_buffer[0],MSD_OUT_EP_SIZE);
+                MSDOutArmed = true;
+            }
+            
+            MSDWriteState = MSD_WRITE10_RX_PACKET;
+            break;
 
-                MSDWriteState = MSD_WRITE10_RX_PACKET;
-                //Fall through to MSD_WRITE10_RX_PACKET // do not!!!
+        case MSD_WRITE10_RX_PACKET:
+            if(USBHandleBusy(USBMSDOutHandle) == true)
+            {
+                MSDOutWaited = true;
                 break;
-      	    }
-      	    else
-      	    {
-                //We finished receiving a sector worth of data from the host.
-                if(LUNWriteProtectState())
-                {
-                    //The device appears to be write protected.
-                    //Let host know error occurred.  The bCSWStatus flag is also used by
-                    //the write handler, to know not to even attempt the write sequence.
-                    msd_csw.bCSWStatus=0x01;
-                    //Set sense keys so the host knows what caused the error.
-                    gblSenseData[LUN_INDEX].SenseKey=S_NOT_READY;
-                    gblSenseData[LUN_INDEX].ASC=ASC_WRITE_PROTECTED;
-                    gblSenseData[LUN_INDEX].ASCQ=ASCQ_WRITE_PROTECTED;
-                }
-
-                MSDWriteState = MSD_WRITE10_SECTOR;
+            }
+            //Hold the packet, the host is NAKed until the media is ready
+            if(LUNWriteReady() == false)
+            {
                 break;
             }
-        }
-        //Fall through to MSD_WRITE10_RX_PACKET
-        case MSD_WRITE10_RX_PACKET:
-            if(USBHandleBusy(USBMSDOutHandle) == true) break;
+            stats.packets++;
+            if(MSDOutWaited)
+            {
+                stats.out_waits++;
+                MSDOutWaited = false;
+            }
+            gblCBW.dCBWDataTransferLength-=USBHandleGetLength(USBMSDOutHandle);		// 64B read
+            msd_csw.dCSWDataResidue-=USBHandleGetLength(USBMSDOutHandle);
+
             // immediately write the data to target !!!
             if(msd_csw.bCSWStatus == 0x00)
             {   // notice the LBA.Val+1 !!!
-                if (LUNSectorWrite(LBA.Val+1, (uint8_t*)&msd_buffer[0], segment++) != true)
+                if (LUNSectorWrite(LBA.Val+1+(packet >> 3), (uint8_t*)&msd_buffer[0], (uint8_t)packet & 7) != true)
                 {   // if failed, communicate immediately, no retries!
                     msd_csw.bCSWStatus = MSD_CSW_COMMAND_FAILED;    // Indicate error during CSW phase
                     // Set error status sense keys, so the host can check them later
@@ -1279,30 +1345,24 @@ uint8_t MSDWriteHandler(void)
                     gblSenseData[LUN_INDEX].ASCQ = ASCQ_NO_ADDITIONAL_SENSE_INFORMATION;
                 }
             }
-            gblCBW.dCBWDataTransferLength-=USBHandleGetLength(USBMSDOutHandle);		// 64B read
-            msd_csw.dCSWDataResidue-=USBHandleGetLength(USBMSDOutHandle);
-//            ptrNextData += MSD_OUT_EP_SIZE; // keep the pointer fixed !!!
+            packet++;
+
+            //The buffer is free again, if the host has more data for us re-arm
+            //the endpoint right away
+            MSDOutArmed = false;
+            if(msd_csw.dCSWDataResidue != 0)
+            {
+                USBMSDOutHandle = USBRxOnePacket(MSD_DATA_OUT_EP,(uint8_t*)&msd_buffer[0],MSD_OUT_EP_SIZE);
+                MSDOutArmed = true;
+            }
             
-            MSDWriteState = MSD_WRITE10_RX_SECTOR;
+            //Only leave the fast path once all the data has been received
+            if(msd_csw.dCSWDataResidue == 0)
+            {
+                MSDWriteState = MSD_WRITE10_BLOCK;
+            }
             break;
             
-        case MSD_WRITE10_SECTOR:
-        {
-            //Make sure that no error has been detected, before performing the write
-            //operation.  If there was an error, skip the write operation, but allow
-            //the TransferLength to continue decrementing, so that we can eventually
-            //receive all OUT bytes that the host is planning on sending us.  Only
-            //after that is complete will the host send the IN token for the CSW packet,
-            //which will contain the bCSWStatus letting it know an error occurred.
-
-            //One LBA is written (unless an error occurred).  Advance state
-            //variables so we can eventually finish handling the CBW request.
-            LBA.Val++;
-            TransferLength.Val--;
-            MSDWriteState = MSD_WRITE10_BLOCK;
-            break;
-        } 
-        
         default:
             //Illegal condition which should not occur.  If for some reason it
             //does, try to let the host know know an error has occurred.
@@ -0,0 +1,765 @@
+/*******************************************************************************
+ XPRESS-Loader host simulation: mass storage host and benchmark
+
+ Copies an image to the simulated drive the way a host would (bulk only
+ transport, FAT12 updates) in several write orders, then checks what ended up
+ in the flash of the loader (or of the ICSP target) against the image.
+ Each copy runs in a child process, starting from a freshly plugged device.
+
+ usage: xpress-sim [--check] [--seed n] [--words n] [--only scenario] [image.hex]
+   --check   exit status 1 if any copy does not meet its expectation
+   --seed    random image contents (and shuffle order)
+   --words   size of the random image, in words
+   --only    run a single scenario
+   image.hex replay an XC8 image instead of a random one (HEX copies verbatim)
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "system.h"
+#include "usb.h"
+#include "usb_device_msd.h"
+#include "app_device_msd.h"
+#include "direct.h"
+#include "files.h"
+#include "memory.h"
+#include "stats.h"
+#include "sim.h"
+
+#if defined(DIRECT_USE_ICSP)
+#define IMAGE_START     0
+#define IMAGE_END       TARGET_END_FLASH
+#else
+#define IMAGE_START     APP_FLASH
+#define IMAGE_END       APP_CRC             // integrity record left to the loader
+#endif
+#define CFG_WORDS       16                  // 0x8000..0x800F
+
+#define SECTOR          512
+#define FILE_MAX        (64 * 1024UL)
+
+/******************************************************************************
+ * Image, as words, and its encodings
+ *****************************************************************************/
+static uint16_t image[ SIM_TARGET_WORDS];
+static uint16_t image_cfg[ CFG_WORDS];
+static uint32_t image_words;                // non blank words
+
+static uint8_t  file_hex[ FILE_MAX];
+static uint32_t file_hex_size;
+static uint8_t  file_bin[ FILE_MAX];
+static uint32_t file_bin_size;
+static uint8_t  file_uf2[ FILE_MAX];
+static uint32_t file_uf2_size;
+
+static uint16_t old_image[ SIM_TARGET_WORDS];    // application found before the copy
+static uint16_t old_flash[ SIM_FLASH_WORDS];    // flash of the loader before the copy
+
+static void imageRandom( uint16_t *words, unsigned seed, uint32_t count)
+{
+    uint32_t i;
+
+    srand( seed);
+    for( i=0; i < SIM_TARGET_WORDS; i++) words[ i] = 0x3fff;
+    for( i=0; (i < count) && (IMAGE_START + i < IMAGE_END); i++)
+        words[ IMAGE_START + i] = (uint16_t)(rand() % 0x3fff);
+    // constant tables placed at the top, as XC8 does
+    for( i=IMAGE_END - 0x60; i < IMAGE_END - 0x20; i++)
+        words[ i] = (uint16_t)(rand() % 0x3fff);
+}
+
+static uint8_t hexNibble( char c)
+{
+    if (c >= 'a') return (uint8_t)(c - 'a' + 10);
+    if (c >= 'A') return (uint8_t)(c - 'A' + 10);
+    return (uint8_t)(c - '0');
+}
+
+/**
+ * Load an Intel HEX file: kept as it is for the HEX copies, decoded in the image
+ */
+static void imageLoad( const char *name)
+{
+    FILE *f = fopen( name, "rb");
+    uint32_t ext = 0, i;
+    char *line;
+
+    if (f == NULL) { perror( name); exit( 2); }
+    file_hex_size = (uint32_t)fread( file_hex, 1, FILE_MAX - 1, f);
+    fclose( f);
+    file_hex[ file_hex_size] = 0;
+    for( i=0; i < SIM_TARGET_WORDS; i++) image[ i] = 0x3fff;
+    for( line = strchr( (char*)file_hex, ':'); line; line = strchr( line + 1, ':')) {
+        uint8_t rec[ 256 + 5];
+        uint8_t n = (uint8_t)(hexNibble( line[1]) * 16 + hexNibble( line[2]));
+        for( i=0; i < n + 5u; i++)
+            rec[ i] = (uint8_t)(hexNibble( line[1 + 2*i]) * 16 + hexNibble( line[2 + 2*i]));
+        uint32_t address = ext + ((uint32_t)rec[ 1] << 8) + rec[ 2];
+        if (rec[ 3] == 4) ext = ((uint32_t)rec[ 4] << 24) + ((uint32_t)rec[ 5] << 16);
+        if (rec[ 3] != 0) continue;
+        for( i=0; i < n; i += 2) {
+            uint32_t word = (address + i) >> 1;
+            uint16_t value = (uint16_t)((rec[ 4 + i] | (rec[ 5 + i] << 8)) & 0x3fff);
+            if (word < IMAGE_START) continue;
+            if (word < IMAGE_END) image[ word] = value;
+            else if ((word >= 0x8000) && (word < 0x8000 + CFG_WORDS)) image_cfg[ word - 0x8000] = value;
+        }
+    }
+}
+
+static char *hexRecordPut( char *p, uint8_t type, uint16_t address, const uint8_t *data, uint8_t n)
+{
+    uint8_t sum = (uint8_t)(n + (address >> 8) + address + type);
+    uint8_t i;
+
+    p += sprintf( p, ":%02X%04X%02X", n, address, type);
+    for( i=0; i < n; i++) {
+        p += sprintf( p, "%02X", data[ i]);
+        sum += data[ i];
+    }
+    return p + sprintf( p, "%02X\r\n", (uint8_t)-sum);
+}
+
+/**
+ * Encode the image as XC8 does: 16 bytes per record, blank words skipped
+ */
+static void encodeHex( void)
+{
+    char *p = (char*)file_hex;
+    uint8_t  data[ 16], ext[ 2];
+    uint32_t word, ext_last = 0xffffffff;
+    uint8_t  i;
+
+    for( word=0; word < 0x8000 + CFG_WORDS; word += 8) {
+        const uint16_t *w = (word < 0x8000) ? &image[ word] : &image_cfg[ word - 0x8000];
+        uint8_t first = 8, last = 0;
+        if ((word >= SIM_TARGET_WORDS) && (word < 0x8000)) continue;
+        for( i=0; i < 8; i++) {
+            if (w[ i] == 0x3fff) continue;
+            if (first == 8) first = i;
+            last = i + 1;
+        }
+        if (first == 8) continue;
+        if (((word * 2) >> 16) != ext_last) {
+            ext_last = (word * 2) >> 16;
+            ext[ 0] = (uint8_t)(ext_last >> 8);
+            ext[ 1] = (uint8_t)ext_last;
+            p = hexRecordPut( p, 4, 0, ext, 2);
+        }
+        for( i=first; i < last; i++) {
+            data[ 2*(i - first)] = (uint8_t)w[ i];
+            data[ 2*(i - first) + 1] = (uint8_t)(w[ i] >> 8);
+        }
+        p = hexRecordPut( p, 0, (uint16_t)((word + first) * 2), data, (uint8_t)(2*(last - first)));
+    }
+    p = hexRecordPut( p, 1, 0, NULL, 0);
+    file_hex_size = (uint32_t)(p - (char*)file_hex);
+}
+
+/**
+ * Raw binary image of the application area, up to the last word used
+ */
+static void encodeBin( void)
+{
+    uint32_t word, end = APP_FLASH;
+
+    for( word=APP_FLASH; word < END_FLASH; word++)
+        if (image[ word] != 0x3fff) end = word + 1;
+    for( word=APP_FLASH; word < end; word++) {
+        file_bin[ (word - APP_FLASH) * 2] = (uint8_t)image[ word];
+        file_bin[ (word - APP_FLASH) * 2 + 1] = (uint8_t)(image[ word] >> 8);
+    }
+    file_bin_size = (end - APP_FLASH) * 2;
+}
+
+#define UF2_PAYLOAD         256
+#define UF2_FLAG_FAMILY     0x00002000UL
+#if defined(DIRECT_USE_ICSP)
+#define UF2_FAMILY          TARGET_UF2_FAMILY
+#else
+#define UF2_FAMILY          DEVICE_UF2_FAMILY
+#endif
+
+static void put32( uint8_t *p, uint32_t v)
+{
+    p[ 0] = (uint8_t)v; p[ 1] = (uint8_t)(v >> 8); p[ 2] = (uint8_t)(v >> 16); p[ 3] = (uint8_t)(v >> 24);
+}
+
+/**
+ * UF2 blocks of 256 bytes, only those holding some data
+ */
+static void encodeUf2( uint32_t flags, uint32_t family)
+{
+    uint32_t word, blocks = 0, n = 0, i;
+    uint32_t addresses[ 2 * SIM_TARGET_WORDS / UF2_PAYLOAD + 1];
+
+    for( word=0; word < SIM_TARGET_WORDS; word += UF2_PAYLOAD / 2) {
+        for( i=0; i < UF2_PAYLOAD / 2; i++) if (image[ word + i] != 0x3fff) break;
+        if (i < UF2_PAYLOAD / 2) addresses[ blocks++] = word * 2;
+    }
+    for( i=0; i < CFG_WORDS; i++) if (image_cfg[ i] != 0x3fff) break;
+    if (i < CFG_WORDS) addresses[ blocks++] = 0x8000 * 2;
+    for( n=0; n < blocks; n++) {
+        uint8_t *b = &file_uf2[ n * SECTOR];
+        memset( b, 0, SECTOR);
+        put32( b + 0, 0x0A324655UL);
+        put32( b + 4, 0x9E5D5157UL);
+        put32( b + 8, flags);
+        put32( b + 12, addresses[ n]);
+        put32( b + 16, UF2_PAYLOAD);
+        put32( b + 20, n);
+        put32( b + 24, blocks);
+        put32( b + 28, family);
+        for( i=0; i < UF2_PAYLOAD / 2; i++) {
+            word = addresses[ n] / 2 + i;
+            word = (word < 0x8000) ? image[ word] : (word < 0x8000 + CFG_WORDS) ? image_cfg[ word - 0x8000] : 0x3fff;
+            b[ 32 + 2*i] = (uint8_t)word;
+            b[ 33 + 2*i] = (uint8_t)(word >> 8);
+        }
+        put32( b + SECTOR - 4, 0x0AB16F30UL);
+    }
+    file_uf2_size = blocks * SECTOR;
+}
+
+/******************************************************************************
+ * Device
+ *****************************************************************************/
+static uint64_t cpu_ns;                     // host time spent in the firmware
+
+void sim_device_poll( void)
+{
+    struct timespec a, b;
+
+    clock_gettime( CLOCK_MONOTONIC, &a);
+    APP_DeviceMSDTasks();
+    clock_gettime( CLOCK_MONOTONIC, &b);
+    cpu_ns += (uint64_t)(b.tv_sec - a.tv_sec) * 1000000000ULL + b.tv_nsec - a.tv_nsec;
+    sim_ns += SIM_T_LOOP;
+}
+
+// application area found at power up
+#define FLASH_OLD       0   // another image
+#define FLASH_SAME      1   // the image being copied
+#define FLASH_BITS      2   // the image with bits set, cleared without erasing
+
+/**
+ * Power up, with a previous (committed) image in the application area
+ */
+static void devicePlug( uint8_t flash)
+{
+    uint16_t i;
+
+    sim_flash_reset( 0x3fff);
+    for( i=APP_FLASH; i < END_FLASH; i++) {
+        if (flash == FLASH_OLD) sim_flash[ i] = old_image[ i];
+        else if (flash == FLASH_SAME) sim_flash[ i] = image[ i];
+        else sim_flash[ i] = image[ i] | 0x0101;
+    }
+#if !defined(DIRECT_USE_ICSP)
+    sim_flash[ APP_MARKER] = APP_COMMITTED;
+#endif
+    memcpy( old_flash, sim_flash, sizeof( old_flash));
+    sim_target_reset();
+    sim_usb_reset();
+    DIRECT_Initialize();
+    STATS_Initialize();
+    APP_DeviceMSDInitialize();
+}
+
+/******************************************************************************
+ * Bulk only transport
+ *****************************************************************************/
+static uint32_t commands;
+static uint32_t tag;
+
+static bool bot( const uint8_t *cdb, uint32_t length, bool in, uint8_t *data)
+{
+    uint8_t  cbw[ 31], csw[ 64];
+    uint32_t pos;
+    int      n;
+
+    memset( cbw, 0, sizeof( cbw));
+    put32( cbw, 0x43425355UL);
+    put32( cbw + 4, ++tag);
+    put32( cbw + 8, length);
+    cbw[ 12] = in ? 0x80 : 0x00;
+    cbw[ 14] = 10;
+    memcpy( cbw + 15, cdb, 10);
+    commands++;
+    sim_ns += SIM_T_TRANSFER;
+    if (!sim_usb_out( MSD_DATA_OUT_EP, cbw, sizeof( cbw))) return false;
+    if (length) sim_ns += SIM_T_TRANSFER;
+    for( pos=0; pos < length; pos += MSD_OUT_EP_SIZE) {
+        if (in) {
+            if (sim_usb_in( MSD_DATA_IN_EP, &data[ pos]) != MSD_IN_EP_SIZE) return false;
+        }
+        else {
+            if (!sim_usb_out( MSD_DATA_OUT_EP, &data[ pos], MSD_OUT_EP_SIZE)) return false;
+        }
+    }
+    sim_ns += SIM_T_TRANSFER;
+    n = sim_usb_in( MSD_DATA_IN_EP, csw);
+    return (n == 13) && (csw[ 0] == 'U') && (csw[ 3] == 'S') && (csw[ 12] == 0);
+}
+
+static bool rw10( uint8_t op, uint32_t lba, uint16_t count, uint8_t *data)
+{
+    uint8_t cdb[ 10] = { op, 0, (uint8_t)(lba >> 24), (uint8_t)(lba >> 16),
+                         (uint8_t)(lba >> 8), (uint8_t)lba, 0, (uint8_t)(count >> 8), (uint8_t)count, 0 };
+
+    return bot( cdb, (uint32_t)count * SECTOR, op == 0x28, data);
+}
+
+#define read10( lba, count, data)   rw10( 0x28, lba, count, data)
+#define write10( lba, count, data)  rw10( 0x2A, lba, count, data)
+
+/******************************************************************************
+ * FAT12 volume
+ *****************************************************************************/
+static uint16_t fat_lba, root_lba, data_lba;
+static uint8_t  fat[ SECTOR], root[ SECTOR];
+
+static uint16_t fatGet( uint16_t n)
+{
+    uint16_t v = fat[ n * 3 / 2] | (fat[ n * 3 / 2 + 1] << 8);
+    return (n & 1) ? v >> 4 : v & 0xfff;
+}
+
+static void fatSet( uint16_t n, uint16_t v)
+{
+    uint8_t *p = &fat[ n * 3 / 2];
+
+    if (n & 1) {
+        p[ 0] = (uint8_t)((p[ 0] & 0x0f) | (v << 4));
+        p[ 1] = (uint8_t)(v >> 4);
+    }
+    else {
+        p[ 0] = (uint8_t)v;
+        p[ 1] = (uint8_t)((p[ 1] & 0xf0) | ((v >> 8) & 0x0f));
+    }
+}
+
+static bool volumeMount( void)
+{
+    uint8_t vbr[ SECTOR];
+
+    if (!read10( 0, 1, vbr)) return false;
+    fat_lba = vbr[ 14] | (vbr[ 15] << 8);
+    root_lba = fat_lba + vbr[ 16] * (vbr[ 22] | (vbr[ 23] << 8));
+    data_lba = root_lba + (vbr[ 17] | (vbr[ 18] << 8)) * 32 / SECTOR;
+    return read10( fat_lba, 1, fat) && read10( root_lba, 1, root);
+}
+
+/**
+ * Fill a long name entry (a single one, order 1 and last) for a short entry
+ */
+static void lfnCreate( uint8_t *entry, const char *name, const uint8_t *short_entry)
+{
+    static const uint8_t pos[ 13] = { 1, 3, 5, 7, 9, 14, 16, 18, 20, 22, 24, 28, 30 };
+    uint8_t  i, sum = 0;
+    size_t   len = strlen( name);
+
+    memset( entry, 0, 32);
+    entry[ 0] = 0x41;
+    for( i=0; i < 13; i++) {
+        uint16_t c = (i < len) ? (uint8_t)name[ i] : (i == len) ? 0 : 0xffff;
+        entry[ pos[ i]] = (uint8_t)c;
+        entry[ pos[ i] + 1] = (uint8_t)(c >> 8);
+    }
+    entry[ 11] = 0x0F;
+    for( i=0; i < 11; i++) sum = (uint8_t)(((sum & 1) << 7) + (sum >> 1) + short_entry[ i]);
+    entry[ 13] = sum;
+}
+
+/**
+ * Allocate the clusters of a new file and add its directory entry
+ * @param gap   leave a free cluster after every 'gap' clusters (0 = contiguous)
+ */
+static uint16_t fileCreate( const char *ext, uint32_t size, uint16_t *clusters, uint8_t gap,
+                            const char *short_name, const char *long_name)
+{
+    uint16_t n = (uint16_t)((size + SECTOR - 1) / SECTOR);
+    uint16_t c = 2, i, skip = 0;
+    uint8_t  *entry;
+
+    for( i=0; i < n; c++) {
+        if (fatGet( c) != 0) continue;
+        if (gap && (i % gap == 0) && i && !skip) { skip = 1; continue; }
+        skip = 0;
+        clusters[ i++] = c;
+    }
+    for( i=0; i < n; i++) fatSet( clusters[ i], (i + 1 < n) ? clusters[ i + 1] : 0xfff);
+    for( entry = root; (entry[ 0] != 0) && (entry[ 0] != 0xE5); entry += 32);
+    if (long_name) {
+        uint8_t *lfn = entry;
+
+        entry += 32;
+        memcpy( entry, short_name, 8);
+        memcpy( entry + 8, ext, 3);
+        lfnCreate( lfn, long_name, entry);
+    }
+    memset( entry, 0, 32);
+    memcpy( entry, short_name ? short_name : "IMAGE   ", 8);
+    memcpy( entry + 8, ext, 3);
+    entry[ 11] = 0x20;
+    entry[ 26] = (uint8_t)clusters[ 0];
+    entry[ 27] = (uint8_t)(clusters[ 0] >> 8);
+    put32( entry + 28, size);
+    return n;
+}
+
+/******************************************************************************
+ * Scenarios
+ *****************************************************************************/
+#define FMT_HEX         0
+#define FMT_BIN         1
+#define FMT_UF2         2
+static const char *fmt_name[] = { "HEX", "BIN", "UF2" };
+
+// write orders of the data sectors
+#define ORDER_SEQUENTIAL    0
+#define ORDER_REVERSE       1
+#define ORDER_ACB           2   // sectors 1 and 2 swapped, 4 and 5 ...
+#define ORDER_SHUFFLE       3
+#define ORDER_RESEND        4   // second sector written twice, last one at the end
+
+// expected outcome
+#define X_NA                0   // not run
+#define X_PASS              1   // programmed and verified, flash matches the image
+#define X_SAFE              2   // may fail, but never reports PASS with a wrong flash
+#define X_IGNORED           3   // nothing programmed, nothing parsed
+#define X_FAIL              4   // data dropped, reported as FAIL, nothing committed
+#define X_ORDER             5   // nothing programmed, reported as ORDER
+
+typedef struct {
+    const char *name;
+    bool     meta_first;        // FAT and root written before the data
+    bool     per_sector;        // one WRITE_10 per data sector
+    uint8_t  order;
+    uint8_t  gap;               // fragmented allocation
+    bool     foreign;           // UF2 family of another device
+    uint8_t  expect[ 3];        // HEX, BIN, UF2
+    const char *short_name;     // 8 chars, NULL = "IMAGE"
+    const char *long_name;      // preceding long name entry (13 chars at most), NULL = none
+    uint16_t extra;             // bytes appended to the file
+    bool     reserved;          // image covers the integrity record (APP_CRC..APP_MARKER)
+    uint8_t  flash;             // FLASH_xxx, no row must be erased unless FLASH_OLD
+    uint8_t  pause_ms;          // host idle between two data commands
+} SCENARIO;
+
+static const SCENARIO scenarios[] = {
+    // name        meta   sector order              gap foreign  HEX      BIN        UF2
+    { "linux",     false, false, ORDER_SEQUENTIAL,  0, false, { X_PASS, X_ORDER,   X_PASS } },
+    { "meta-first",true,  false, ORDER_SEQUENTIAL,  0, false, { X_PASS, X_PASS,    X_PASS } },
+    { "per-sector",true,  true,  ORDER_SEQUENTIAL,  0, false, { X_PASS, X_PASS,    X_PASS } },
+    { "fragmented",true,  true,  ORDER_SEQUENTIAL,  5, false, { X_PASS, X_PASS,    X_PASS } },
+    { "reverse",   true,  true,  ORDER_REVERSE,     0, false, { X_PASS, X_PASS,    X_PASS } },
+    { "acb",       true,  true,  ORDER_ACB,         0, false, { X_PASS, X_PASS,    X_PASS } },
+    { "shuffle",   true,  true,  ORDER_SHUFFLE,     0, false, { X_SAFE, X_PASS,    X_PASS } },
+    { "resend",    true,  true,  ORDER_RESEND,      0, false, { X_NA,   X_NA,      X_PASS } },
+    { "foreign",   true,  true,  ORDER_SEQUENTIAL,  0, true,  { X_NA,   X_NA,      X_IGNORED } },
+    { "underscore",true,  false, ORDER_SEQUENTIAL,  0, false, { X_PASS, X_NA,      X_NA }, "_IMAGE  " },
+    { "appledbl",  true,  false, ORDER_SEQUENTIAL,  0, false, { X_IGNORED, X_NA,   X_NA }, "_IMAGE~1", "._image.hex" },
+    { "oversize",  true,  false, ORDER_SEQUENTIAL,  0, false, { X_NA,   X_FAIL,    X_NA }, NULL, NULL, 1024 },
+    { "reserved",  true,  false, ORDER_SEQUENTIAL,  0, false, { X_FAIL, X_FAIL,    X_FAIL }, NULL, NULL, 0, true },
+    { "again",     true,  true,  ORDER_SEQUENTIAL,  0, false, { X_PASS, X_PASS,    X_PASS }, NULL, NULL, 0, false, FLASH_SAME, 5 },
+    { "clear-bits",true,  true,  ORDER_SEQUENTIAL,  0, false, { X_PASS, X_PASS,    X_PASS }, NULL, NULL, 0, false, FLASH_BITS, 5 },
+};
+
+static unsigned seed = 1;
+
+static uint16_t writeOrder( const SCENARIO *s, uint16_t n, uint16_t *order)
+{
+    uint16_t i, j, t, count = n;
+
+    for( i=0; i < n; i++) order[ i] = i;
+    switch( s->order) {
+        case ORDER_REVERSE:
+            for( i=0; i < n; i++) order[ i] = n - 1 - i;
+            break;
+        case ORDER_ACB:
+            for( i=1; i + 1 < n; i += 3) { t = order[ i]; order[ i] = order[ i+1]; order[ i+1] = t; }
+            break;
+        case ORDER_SHUFFLE:
+            srand( seed);
+            for( i=n - 1; i > 0; i--) { j = (uint16_t)(rand() % (i + 1)); t = order[ i]; order[ i] = order[ j]; order[ j] = t; }
+            break;
+        case ORDER_RESEND:
+            if (n < 3) break;
+            for( i=n; i > 2; i--) order[ i] = order[ i-1];
+            order[ 2] = 1;                  // 0, 1, 1, 2, .. n-2
+            count = n + 1;
+            break;
+    }
+    return count;
+}
+
+typedef struct {
+    bool     ok;
+    uint32_t file_size;
+    uint32_t commands;
+    uint64_t copy_ns;
+    uint64_t done_ns;
+    uint64_t cpu_ns;
+    uint32_t packets;
+    uint32_t out_waits;
+    uint32_t parse_errors;
+    uint64_t stall_ns;
+    uint32_t erases, writes;
+    uint32_t data_bytes;
+    uint8_t  result;
+    bool     match;
+    bool     changed;
+    bool     committed;         // commit marker present in the application area
+    uint32_t rows, busy_violations, protocol_errors;
+    uint64_t target_ns, busy_ns;        // first to last row, busy with timed operations
+    char     note[ 64];
+} RUN;
+
+static bool flashMatches( bool *changed)
+{
+    uint32_t i;
+
+#if defined(DIRECT_USE_ICSP)
+    *changed = (sim_target.rows != 0) || (sim_target.cfg_words != 0);
+    for( i=0; i < SIM_TARGET_WORDS; i++)
+        if (sim_target.flash[ i] != ((i < IMAGE_END) ? image[ i] : 0x3fff)) return false;
+    for( i=7; i < 7 + TARGET_CFG_NUM; i++)
+        if (sim_target.cfg[ i] != image_cfg[ i]) return false;
+    return true;
+#else
+    *changed = (memcmp( sim_flash, old_flash, sizeof( sim_flash)) != 0);
+    if (sim_flash_stats.loader_writes) return false;
+    for( i=APP_FLASH; i < IMAGE_END; i++)
+        if (sim_flash[ i] != image[ i]) return false;
+    return true;
+#endif
+}
+
+static void copy( const SCENARIO *s, uint8_t fmt, RUN *r)
+{
+    const uint8_t *file = (fmt == FMT_HEX) ? file_hex : (fmt == FMT_BIN) ? file_bin : file_uf2;
+    uint32_t size = (fmt == FMT_HEX) ? file_hex_size : (fmt == FMT_BIN) ? file_bin_size : file_uf2_size;
+    uint32_t data = size;
+    static uint8_t  padded[ FILE_MAX + SECTOR];
+    static uint16_t clusters[ FILE_MAX / SECTOR + 1], order[ FILE_MAX / SECTOR + 2];
+    uint16_t n, count, i, run;
+    uint64_t start, start_pause;
+
+    memset( r, 0, sizeof( *r));
+    devicePlug( s->flash);
+    r->ok = volumeMount();
+    size += s->extra;
+    n = fileCreate( fmt_name[ fmt], size, clusters, s->gap, s->short_name, s->long_name);
+    memset( padded, 0, sizeof( padded));
+    memcpy( padded, file, data);
+    count = writeOrder( s, n, order);
+    start = sim_ns;
+    cpu_ns = 0;
+    commands = 0;
+    if (s->meta_first)
+        r->ok = r->ok && write10( fat_lba, 1, fat) && write10( root_lba, 1, root);
+    for( i=0; r->ok && (i < count); i += run) {
+        // contiguous clusters in sequence go in a single command
+        for( run=1; !s->per_sector && (i + run < count) && (order[ i + run] == order[ i] + run) &&
+                    (clusters[ order[ i + run]] == clusters[ order[ i]] + run); run++);
+        r->ok = write10( data_lba + clusters[ order[ i]] - 2, run, &padded[ order[ i] * SECTOR]);
+        for( start_pause = sim_ns; sim_ns - start_pause < s->pause_ms * SIM_MS; ) sim_device_poll();
+    }
+    if (!s->meta_first)
+        r->ok = r->ok && write10( fat_lba, 1, fat) && write10( root_lba, 1, root);
+    r->copy_ns = sim_ns - start;
+    r->cpu_ns = cpu_ns;                 // packets of the copy, not the idle polling
+    r->commands = commands;
+    // idle bus: background tasks until the sequence is complete (5s at most)
+    while( sim_ns - start < r->copy_ns + 5000 * SIM_MS) {
+#if defined(DIRECT_USE_ICSP)
+        if (!DIRECT_ProgrammingInProgress()) break;
+#else
+        if ((direct_stats.result != DIRECT_RESULT_NONE) && !DIRECT_ProgrammingInProgress()) break;
+#endif
+        sim_device_poll();
+    }
+    r->done_ns = sim_ns - start;
+    r->file_size = size;
+    r->packets = stats.packets;
+    r->out_waits = stats.out_waits;
+    r->parse_errors = stats.parse_errors;
+    r->stall_ns = sim_flash_stats.stall_ns;
+    r->erases = sim_flash_stats.erases;
+    r->writes = sim_flash_stats.writes;
+    r->data_bytes = direct_stats.data_bytes;
+    r->result = direct_stats.result;
+    r->match = flashMatches( &r->changed);
+#if !defined(DIRECT_USE_ICSP)
+    r->committed = (sim_flash[ APP_MARKER] == APP_COMMITTED);
+#endif
+    r->rows = sim_target.rows;
+    r->busy_violations = sim_target.busy_violations;
+    r->protocol_errors = sim_target.protocol_errors;
+    r->target_ns = sim_target.last_ns - sim_target.first_ns;
+    r->busy_ns = sim_target.busy_ns;
+    if (sim_usb_stalled()) r->ok = false;
+}
+
+/**
+ * Compare a copy with its expectation
+ */
+static bool judge( const SCENARIO *s, uint8_t expect, RUN *r)
+{
+    if (!r->ok) { strcpy( r->note, "USB transfer failed"); return false; }
+#if defined(DIRECT_USE_ICSP)
+    if (r->busy_violations || r->protocol_errors) { strcpy( r->note, "ICSP sequence error"); return false; }
+    if ((expect == X_IGNORED) || (expect == X_ORDER)) {
+        if (r->changed || r->parse_errors) { strcpy( r->note, "target programmed"); return false; }
+        return true;
+    }
+    if (!r->match && (expect == X_SAFE) && (r->result == DIRECT_RESULT_FAIL)) {
+        strcpy( r->note, "not programmed (safe)");
+        return true;
+    }
+    if (!r->match) { strcpy( r->note, "target differs"); return false; }
+    return true;
+#else
+    switch( expect) {
+        case X_IGNORED:
+            if (r->changed) { strcpy( r->note, "flash modified"); return false; }
+            if (r->parse_errors) { strcpy( r->note, "decoded as HEX"); return false; }
+            return true;
+        case X_ORDER:
+            if (r->changed) { strcpy( r->note, "flash modified"); return false; }
+            if (r->result != DIRECT_RESULT_ORDER) { strcpy( r->note, "not reported"); return false; }
+            return true;
+        case X_FAIL:
+            if (r->result != DIRECT_RESULT_FAIL) { strcpy( r->note, "not reported as FAIL"); return false; }
+            if (r->committed) { strcpy( r->note, "committed"); return false; }
+            return true;
+        case X_SAFE:
+            if ((r->result == DIRECT_RESULT_PASS) && !r->match) { strcpy( r->note, "PASS but flash differs"); return false; }
+            if (r->result != DIRECT_RESULT_PASS) strcpy( r->note, "not programmed (safe)");
+            return true;
+        default:
+            if ((r->result == DIRECT_RESULT_PASS) && !r->match) { strcpy( r->note, "PASS but flash differs"); return false; }
+            if (r->result != DIRECT_RESULT_PASS) { strcpy( r->note, "not verified"); return false; }
+            // the commit rewrites the last row
+            if ((s->flash != FLASH_OLD) && (r->erases > 1)) { strcpy( r->note, "rows erased"); return false; }
+            return true;
+    }
+#endif
+}
+
+static const char *result_name[] = { "NONE", "PASS", "FAIL", "EMPTY", "ORDER" };
+
+static void report( const SCENARIO *s, uint8_t fmt, const RUN *r, bool pass)
+{
+    double copy_ms = r->copy_ns / 1e6, done_ms = r->done_ns / 1e6;
+
+    printf( "%-11s %s %6u %4u %8.1f %6.1f %8.1f %6.1f %7.1f %4u %4u %5u %5u %6.0f  %-5s %s %s\n",
+        s->name, fmt_name[ fmt], r->file_size, r->commands, copy_ms,
+        copy_ms ? r->file_size / 1.024 / copy_ms : 0.0,
+        done_ms, done_ms * 512 / image_words,
+        r->stall_ns / 1e6, r->erases, r->writes, r->packets, r->out_waits,
+        r->packets ? (double)r->cpu_ns / r->packets : 0.0,
+        result_name[ r->result % 5], pass ? "ok" : "FAILED", r->note);
+#if defined(DIRECT_USE_ICSP)
+    if (r->rows)
+        printf( "%-11s     target: %u rows, %.0f rows/s, busy %.1f ms, %u busy violations, %u protocol errors\n", "",
+            r->rows, r->rows * 1e9 / (double)(r->target_ns + 1), r->busy_ns / 1e6, r->busy_violations, r->protocol_errors);
+#endif
+}
+
+int main( int argc, char **argv)
+{
+    bool check = false;
+    const char *only = NULL, *name = NULL;
+    uint32_t words = 0x800;
+    unsigned i, failures = 0;
+    uint8_t fmt;
+#if !defined(DIRECT_USE_ICSP)
+    uint32_t w;
+#endif
+
+    for( i=1; i < (unsigned)argc; i++) {
+        if (!strcmp( argv[ i], "--check")) check = true;
+        else if (!strcmp( argv[ i], "--seed") && (i + 1 < (unsigned)argc)) seed = (unsigned)atoi( argv[ ++i]);
+        else if (!strcmp( argv[ i], "--words") && (i + 1 < (unsigned)argc)) words = (uint32_t)strtoul( argv[ ++i], NULL, 0);
+        else if (!strcmp( argv[ i], "--only") && (i + 1 < (unsigned)argc)) only = argv[ ++i];
+        else if (argv[ i][ 0] != '-') name = argv[ i];
+        else { fprintf( stderr, "usage: %s [--check] [--seed n] [--words n] [--only scenario] [image.hex]\n", argv[ 0]); return 2; }
+    }
+    for( i=0; i < CFG_WORDS; i++) image_cfg[ i] = 0x3fff;
+    if (name) {
+        imageLoad( name);
+    }
+    else {
+        imageRandom( image, seed, words);
+#if defined(DIRECT_USE_ICSP)
+        for( i=7; i < 7 + TARGET_CFG_NUM; i++) image_cfg[ i] = (uint16_t)(0x3f00 | i);
+#endif
+        encodeHex();
+    }
+    encodeBin();
+    imageRandom( old_image, seed + 1000, words);
+    for( i=0; i < SIM_TARGET_WORDS; i++) if (image[ i] != 0x3fff) image_words++;
+
+#if defined(DIRECT_USE_ICSP)
+    printf( "LVP-ICSP target, image %u words\n", image_words);
+#else
+    printf( "self-programming, image %u words\n", image_words);
+#endif
+    printf( "%-11s fmt  bytes cmds  copy ms   KB/s  done ms  ms/KB stall ms  ers  wrt  pkts waits ns/pkt  result\n", "scenario");
+    for( i=0; i < sizeof( scenarios) / sizeof( scenarios[ 0]); i++) {
+        const SCENARIO *s = &scenarios[ i];
+        if (only && strcmp( only, s->name)) continue;
+#if defined(DIRECT_USE_ICSP)
+        if (s->reserved) continue;              // the integrity record belongs to the loader
+        if (s->flash != FLASH_OLD) continue;    // the target is blank
+#else
+        if (s->reserved) {
+            for( w=APP_CRC; w < END_FLASH; w++) image[ w] = (uint16_t)(0x1000 + w);
+            encodeHex();
+            encodeBin();
+        }
+#endif
+        for( fmt=FMT_HEX; fmt <= FMT_UF2; fmt++) {
+            RUN r;
+            int fd[ 2];
+            pid_t pid;
+            bool pass;
+#if defined(DIRECT_USE_ICSP)
+            if (fmt == FMT_BIN) continue;       // the BIN image maps to the loader application area
+#endif
+            if (s->expect[ fmt] == X_NA) continue;
+            encodeUf2( UF2_FLAG_FAMILY, s->foreign ? 0x12345678UL : UF2_FAMILY);
+            // each copy starts from a freshly plugged device
+            if (pipe( fd) != 0) return 2;
+            pid = fork();
+            if (pid == 0) {
+                close( fd[ 0]);
+                copy( s, fmt, &r);
+                if (write( fd[ 1], &r, sizeof( r)) != sizeof( r)) _exit( 2);
+                _exit( 0);
+            }
+            close( fd[ 1]);
+            memset( &r, 0, sizeof( r));
+            if (read( fd[ 0], &r, sizeof( r)) != sizeof( r)) strcpy( r.note, "simulation crashed");
+            close( fd[ 0]);
+            waitpid( pid, NULL, 0);
+            pass = judge( s, s->expect[ fmt], &r);
+            if (!pass) failures++;
+            report( s, fmt, &r, pass);
+        }
+#if !defined(DIRECT_USE_ICSP)
+        if (s->reserved) {
+            for( w=APP_CRC; w < END_FLASH; w++) image[ w] = 0x3fff;
+            encodeHex();
+            encodeBin();
+        }
+#endif
+    }
+    if (failures) printf( "%u copies did not meet their expectation\n", failures);
+    return (check && failures) ? 1 : 0;
+}
@@ -0,0 +1,151 @@
+/*******************************************************************************
+ XPRESS-Loader host simulation: registers, flash and time of the PIC16F1455
+ ******************************************************************************/
+#include <string.h>
+#include <xc.h>
+#include "memory.h"
+#include "stats.h"
+#include "sim.h"
+
+uint64_t sim_ns;
+
+volatile TRISCbits_t TRISCbits;
+volatile TRISAbits_t TRISAbits;
+volatile PORTAbits_t PORTAbits;
+volatile PORTCbits_t PORTCbits;
+volatile PMCON1bits_t PMCON1bits;
+volatile uint8_t PMADRL, PMADRH, PMDATL, PMDATH, PMCON2;
+volatile INTCONbits_t INTCONbits;
+volatile PIR1bits_t PIR1bits;
+volatile PIE1bits_t PIE1bits;
+volatile PWM2CONbits_t PWM2CONbits;
+volatile uint8_t OPTION_REG, PIE1, PIE2, PIR2;
+volatile uint8_t TMR1H, TMR1L, T1CON, T1GCON, TMR2, PR2, T2CON;
+volatile uint8_t PWM2CON, PWM2DCH, PWM2DCL;
+volatile UCONbits_t UCONbits;
+volatile uint8_t UCON, UIE, UIR, UEIE, UEIR, UADDR, UCFG;
+
+/******************************************************************************
+ * Flash, self-programmed through PMCON1/PMADR/PMDAT (memory.c)
+ *****************************************************************************/
+uint16_t sim_flash[ SIM_FLASH_WORDS];
+SIM_FLASH_STATS sim_flash_stats;
+static uint16_t latch[ WRITE_FLASH_BLOCKSIZE];
+
+void sim_flash_reset( uint16_t value)
+{
+    uint16_t i;
+
+    for( i=0; i < SIM_FLASH_WORDS; i++) sim_flash[ i] = value;
+    for( i=0; i < WRITE_FLASH_BLOCKSIZE; i++) latch[ i] = 0x3fff;
+    memset( &sim_flash_stats, 0, sizeof( sim_flash_stats));
+}
+
+static void flashStall( uint64_t ns)
+{
+    sim_ns += ns;
+    sim_flash_stats.stall_ns += ns;
+}
+
+/**
+ * Complete the operation started by setting RD or WR
+ * Writes only clear bits: the words not loaded in the latches stay unchanged.
+ */
+void sim_nop( void)
+{
+    uint16_t address = (((uint16_t)PMADRH << 8) | PMADRL) & (SIM_FLASH_WORDS - 1);
+    uint16_t row = address & ~(ERASE_FLASH_BLOCKSIZE - 1);
+    uint8_t  i;
+
+    if (PMCON1bits.RD) {
+        PMDATL = (uint8_t)sim_flash[ address];
+        PMDATH = (uint8_t)(sim_flash[ address] >> 8);
+        PMCON1bits.RD = 0;
+        return;
+    }
+    if (!PMCON1bits.WR) return;
+    PMCON1bits.WR = 0;
+    if (!PMCON1bits.WREN) return;
+    if (PMCON1bits.FREE) {
+        if (row < APP_FLASH) sim_flash_stats.loader_writes++;
+        for( i=0; i < ERASE_FLASH_BLOCKSIZE; i++) sim_flash[ row + i] = 0x3fff;
+        PMCON1bits.FREE = 0;        // cleared by hardware
+        sim_flash_stats.erases++;
+        flashStall( SIM_T_ERASE);
+        return;
+    }
+    latch[ address & (WRITE_FLASH_BLOCKSIZE - 1)] = (((uint16_t)PMDATH << 8) | PMDATL) & 0x3fff;
+    if (PMCON1bits.LWLO) return;    // latches only
+    address &= ~(WRITE_FLASH_BLOCKSIZE - 1);
+    if (address < APP_FLASH) sim_flash_stats.loader_writes++;
+    for( i=0; i < WRITE_FLASH_BLOCKSIZE; i++) {
+        sim_flash[ address + i] &= latch[ i];
+        latch[ i] = 0x3fff;
+    }
+    sim_flash_stats.writes++;
+    flashStall( SIM_T_WRITE);
+}
+
+/******************************************************************************
+ * Time
+ *****************************************************************************/
+void sim_delay_us( uint32_t us)
+{
+    (void)sim_latc();               // pins settled before the delay
+    sim_ns += us * SIM_US;
+}
+
+/**
+ * Fosc/4 with 1:256 prescaler (see stats.h), each read costs a poll
+ */
+uint8_t sim_tmr0( void)
+{
+    static uint64_t overflows;          // passed to the interrupt handler
+    uint64_t ticks;
+
+    sim_ns += SIM_T_POLL;
+    ticks = sim_ns * 3 / 64000;
+    while( overflows < (ticks >> 8)) {
+        overflows++;
+        if (!INTCONbits.GIE || !INTCONbits.TMR0IE) continue;
+        INTCONbits.TMR0IF = 1;
+        STATS_InterruptHandler();
+    }
+    return (uint8_t)ticks;
+}
+
+uint32_t USBGet1msTickCount( void)
+{
+    return (uint32_t)(sim_ns / SIM_MS);
+}
+
+/******************************************************************************
+ * Pins, any change since the previous access is passed on to the target
+ *****************************************************************************/
+static volatile LATCbits_t latc;
+static volatile LATAbits_t lata = { .LATA4 = 1 };    // target released
+
+static void pinsSample( void)
+{
+    static SIM_PINS last = { false, false, true };
+    SIM_PINS now;
+
+    now.clk = latc.LATC0;
+    now.dat = latc.LATC1;
+    now.mclr = lata.LATA4;
+    if (memcmp( &now, &last, sizeof( now)) == 0) return;
+    last = now;
+    sim_target_pins( &now);
+}
+
+volatile LATCbits_t *sim_latc( void)
+{
+    pinsSample();
+    return &latc;
+}
+
+volatile LATAbits_t *sim_lata( void)
+{
+    pinsSample();
+    return &lata;
+}
@@ -0,0 +1,85 @@
+/*******************************************************************************
+ XPRESS-Loader host simulation
+
+ The firmware modules of the MSD programming pipeline (usb_device_msd.c,
+ app_device_msd.c, direct.c, files.c, memory.c, icsp.c) are compiled as they
+ are for the host, against:
+ - pic.c     the registers of xc.h, the flash of the loader device and the
+             simulated time
+ - usb.c     the buffer descriptors of the USB module (replaces usb_device.c)
+ - target.c  a PIC16F188xx answering the LVP-ICSP commands (DIRECT_USE_ICSP)
+ - host.c    a USB mass storage host copying images to the drive
+ ******************************************************************************/
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// simulated time, in ns
+#define SIM_US              1000ULL
+#define SIM_MS              1000000ULL
+
+// loader device timing (PIC16F1455 datasheet, typical)
+#define SIM_T_ERASE         (2 * SIM_MS)    // row erase, CPU stalled
+#define SIM_T_WRITE         (2 * SIM_MS)    // row write, CPU stalled
+#define SIM_T_POLL          (1 * SIM_US)    // each TMR0 read (polling loops)
+#define SIM_T_LOOP          (10 * SIM_US)   // each main loop iteration
+
+// USB full speed bus, as seen by the device
+#define SIM_T_PACKET        (54 * SIM_US)   // 64 byte bulk packet and handshake
+#define SIM_T_TRANSFER      (125 * SIM_US)  // host turnaround between CBW, data and CSW
+
+extern uint64_t sim_ns;
+
+// flash of the loader device, 14-bit words
+#define SIM_FLASH_WORDS     0x2000
+extern uint16_t sim_flash[ SIM_FLASH_WORDS];
+
+typedef struct {
+    uint32_t erases;            // rows erased
+    uint32_t writes;            // rows written
+    uint32_t loader_writes;     // erases/writes below the application area
+    uint64_t stall_ns;          // CPU stalled by flash operations
+} SIM_FLASH_STATS;
+extern SIM_FLASH_STATS sim_flash_stats;
+
+void sim_flash_reset( uint16_t value);
+
+// pins driven by the firmware, sampled at each access of LATA/LATC
+typedef struct {
+    bool clk;
+    bool dat;
+    bool mclr;
+} SIM_PINS;
+
+// PIC16F188xx target (target.c)
+#define SIM_TARGET_WORDS    0x8000
+typedef struct {
+    uint16_t flash[ SIM_TARGET_WORDS];
+    uint16_t cfg[ 16];          // 0x8000..0x800F
+    uint32_t entries;           // key sequences recognized
+    uint32_t bulk_erases;
+    uint32_t rows;              // rows programmed
+    uint32_t cfg_words;         // configuration words programmed
+    uint32_t busy_violations;   // commands clocked during a timed operation
+    uint32_t protocol_errors;   // unknown commands, writes outside the row
+    uint64_t first_ns;          // start of the first row write
+    uint64_t last_ns;           // end of the last timed operation
+    uint64_t busy_ns;           // total time in timed operations
+} SIM_TARGET;
+extern SIM_TARGET sim_target;
+
+void sim_target_reset( void);
+void sim_target_pins( const SIM_PINS *pins);
+
+// USB module (usb.c), host side of the MSD bulk endpoints
+void sim_usb_reset( void);
+bool sim_usb_out( uint8_t ep, const uint8_t *data, uint8_t len);
+int  sim_usb_in( uint8_t ep, uint8_t *data);
+bool sim_usb_stalled( void);
+
+// device side, one iteration of the main loop (host.c)
+void sim_device_poll( void);
+
+#endif  /* SIM_H */
@@ -0,0 +1,192 @@
+/*******************************************************************************
+ XPRESS-Loader host simulation: PIC16F188xx LVP-ICSP target
+
+ Decodes the pins driven by icsp.c (data latched on the falling edge of the
+ clock, MSB first) as the target would: the 32-bit key with MCLR low, then
+ 8-bit commands, followed by a 24-bit payload for the LOAD commands.
+ The internally timed operations keep the target busy for their datasheet
+ duration, a command clocked before its end is counted as a violation.
+ ******************************************************************************/
+#include <string.h>
+#include "sim.h"
+
+// 8-bit command set
+#define CMD_LOAD_PC         0x80
+#define CMD_BULK_ERASE      0x18
+#define CMD_LOAD_DATA       0x00
+#define CMD_LOAD_DATA_INC   0x02
+#define CMD_READ_DATA       0xFC
+#define CMD_READ_DATA_INC   0xFE
+#define CMD_INC_ADDRESS     0xF8
+#define CMD_BEGIN_INT_PROG  0xE0
+
+#define KEY                 0x4D434850UL    // "MCHP"
+#define ROW_SIZE            32
+
+// PIC16F18855 datasheet, maximum
+#define T_PINT              (2800 * SIM_US) // row write
+#define T_PINT_CFG          (5600 * SIM_US) // configuration word write
+#define T_ERAB              (8400 * SIM_US) // bulk erase
+
+// shift register contents expected next
+#define SHIFT_OFF           0   // MCLR high
+#define SHIFT_KEY           1
+#define SHIFT_COMMAND       2
+#define SHIFT_PAYLOAD       3
+
+SIM_TARGET sim_target;
+
+static SIM_PINS pins = { false, false, true };
+static uint8_t  shift_state;
+static uint32_t shift;
+static uint8_t  shift_count;
+static uint8_t  command;
+static uint16_t pc;
+static uint16_t latch[ ROW_SIZE];
+static uint64_t busy_until;
+
+static void blank( uint16_t *words, uint16_t count)
+{
+    while( count--) *words++ = 0x3fff;
+}
+
+void sim_target_reset( void)
+{
+    memset( &sim_target, 0, sizeof( sim_target));
+    blank( sim_target.flash, SIM_TARGET_WORDS);
+    blank( sim_target.cfg, 16);
+    shift_state = SHIFT_OFF;
+    busy_until = 0;
+}
+
+static void latchReset( void)
+{
+    uint8_t i;
+
+    for( i=0; i < ROW_SIZE; i++) latch[ i] = 0x3fff;
+}
+
+static void timed( uint64_t ns)
+{
+    busy_until = sim_ns + ns;
+    sim_target.busy_ns += ns;
+    sim_target.last_ns = busy_until;
+}
+
+static void loadData( uint16_t data)
+{
+    if (pc >= 0x8000) {                 // configuration space, one word at a time
+        latch[ 0] = data & 0x3fff;
+        return;
+    }
+    latch[ pc & (ROW_SIZE - 1)] = data & 0x3fff;
+}
+
+static void beginProgramming( void)
+{
+    uint16_t row = pc & ~(ROW_SIZE - 1);
+    uint8_t  i;
+
+    if (pc >= 0x8000) {
+        if ((pc - 0x8000) < 16) sim_target.cfg[ pc - 0x8000] &= latch[ 0];
+        else sim_target.protocol_errors++;
+        sim_target.cfg_words++;
+        latchReset();
+        timed( T_PINT_CFG);
+        return;
+    }
+    if (sim_target.rows == 0) sim_target.first_ns = sim_ns;
+    for( i=0; i < ROW_SIZE; i++) sim_target.flash[ row + i] &= latch[ i];
+    sim_target.rows++;
+    latchReset();
+    timed( T_PINT);
+}
+
+static void execute( void)
+{
+    switch( command) {
+        case CMD_BULK_ERASE:
+            blank( sim_target.flash, SIM_TARGET_WORDS);
+            if (pc >= 0x8000) blank( sim_target.cfg, 16);
+            sim_target.bulk_erases++;
+            timed( T_ERAB);
+            break;
+        case CMD_BEGIN_INT_PROG:
+            beginProgramming();
+            break;
+        case CMD_INC_ADDRESS:
+            pc++;
+            break;
+        default:
+            sim_target.protocol_errors++;
+            break;
+    }
+}
+
+static void payload( uint32_t value)
+{
+    uint16_t data = (uint16_t)(value >> 1);
+
+    switch( command) {
+        case CMD_LOAD_PC:
+            pc = data;
+            break;
+        case CMD_LOAD_DATA:
+            loadData( data);
+            break;
+        case CMD_LOAD_DATA_INC:
+            loadData( data);
+            if (((pc + 1) & (ROW_SIZE - 1)) == 0) sim_target.protocol_errors++;  // leaves the row
+            pc++;
+            break;
+    }
+}
+
+static void clockBit( bool bit)
+{
+    shift = (shift << 1) | bit;
+    shift_count++;
+    switch( shift_state) {
+        case SHIFT_KEY:
+            if (shift_count < 32) return;
+            if (shift == KEY) {
+                sim_target.entries++;
+                shift_state = SHIFT_COMMAND;
+                latchReset();
+            }
+            else sim_target.protocol_errors++;
+            break;
+        case SHIFT_COMMAND:
+            if (shift_count == 1 && sim_ns < busy_until) sim_target.busy_violations++;
+            if (shift_count < 8) return;
+            command = (uint8_t)shift;
+            if ((command == CMD_LOAD_PC) || (command == CMD_LOAD_DATA) ||
+                (command == CMD_LOAD_DATA_INC)) {
+                shift_state = SHIFT_PAYLOAD;
+            }
+            else {
+                execute();
+            }
+            break;
+        case SHIFT_PAYLOAD:
+            if (shift_count < 24) return;
+            payload( shift & 0xffffff);
+            shift_state = SHIFT_COMMAND;
+            break;
+    }
+    shift = 0;
+    shift_count = 0;
+}
+
+void sim_target_pins( const SIM_PINS *now)
+{
+    if (now->mclr != pins.mclr) {
+        shift_state = now->mclr ? SHIFT_OFF : SHIFT_KEY;
+        shift = 0;
+        shift_count = 0;
+    }
+    else if ((shift_state != SHIFT_OFF) && pins.clk && !now->clk) {
+        clockBit( now->dat);
+    }
+    pins = *now;
+}
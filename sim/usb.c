@@ -0,0 +1,124 @@
+/*******************************************************************************
+ XPRESS-Loader host simulation: USB module
+
+ Replaces usb_device.c for the application endpoints: USBTransferOnePacket()
+ arms the buffer descriptors as the stack does (full ping-pong), the host
+ side completes them in the same order as the SIE would. The buffer address
+ does not fit the 16-bit BDT field on the host, it is kept aside.
+ ******************************************************************************/
+#include <string.h>
+#include "system.h"
+#include "usb.h"
+#include "sim.h"
+
+#define POLLS_MAX   1000000UL   // device polls before a transfer is given up
+
+volatile BDT_ENTRY* pBDTEntryOut[ USB_MAX_EP_NUMBER + 1];
+volatile BDT_ENTRY* pBDTEntryIn[ USB_MAX_EP_NUMBER + 1];
+volatile uint8_t CtrlTrfData[ USB_EP0_BUFF_SIZE];
+USB_VOLATILE USB_DEVICE_STATE USBDeviceState;
+USB_VOLATILE IN_PIPE inPipes[ 1];
+volatile CTRL_TRF_SETUP SetupPkt;
+
+static volatile BDT_ENTRY bdt[ USB_MAX_EP_NUMBER + 1][ 2][ 2];    // [ep][dir][even/odd]
+static uint8_t *bdt_data[ USB_MAX_EP_NUMBER + 1][ 2][ 2];
+static uint8_t host_odd[ USB_MAX_EP_NUMBER + 1][ 2];              // next BD the SIE uses
+static bool    stalled;
+
+void sim_usb_reset( void)
+{
+    memset( (void*)bdt, 0, sizeof( bdt));
+    memset( host_odd, 0, sizeof( host_odd));
+    stalled = false;
+    USBDeviceState = CONFIGURED_STATE;
+}
+
+void USBEnableEndpoint( uint8_t ep, uint8_t options)
+{
+    if (options & USB_OUT_ENABLED) {
+        pBDTEntryOut[ ep] = &bdt[ ep][ OUT_FROM_HOST][ 0];
+        host_odd[ ep][ OUT_FROM_HOST] = 0;
+    }
+    if (options & USB_IN_ENABLED) {
+        pBDTEntryIn[ ep] = &bdt[ ep][ IN_TO_HOST][ 0];
+        host_odd[ ep][ IN_TO_HOST] = 0;
+    }
+}
+
+USB_HANDLE USBTransferOnePacket( uint8_t ep, uint8_t dir, uint8_t* data, uint8_t len)
+{
+    volatile BDT_ENTRY *handle = (dir != 0) ? pBDTEntryIn[ ep] : pBDTEntryOut[ ep];
+    uint8_t odd;
+
+    if (handle == 0) return 0;
+    odd = (uint8_t)(handle - &bdt[ ep][ dir][ 0]);
+    bdt_data[ ep][ dir][ odd] = data;
+    handle->CNT = len;
+    handle->STAT.Val = _USIE;
+    // next buffer for ping pong purposes
+    if (dir != 0) pBDTEntryIn[ ep] = &bdt[ ep][ dir][ odd ^ 1];
+    else pBDTEntryOut[ ep] = &bdt[ ep][ dir][ odd ^ 1];
+    return (USB_HANDLE)handle;
+}
+
+void USBStallEndpoint( uint8_t ep, uint8_t dir)
+{
+    volatile BDT_ENTRY *handle = (dir != 0) ? pBDTEntryIn[ ep] : pBDTEntryOut[ ep];
+
+    handle->STAT.Val = _USIE | _BSTALL;
+    stalled = true;
+}
+
+bool sim_usb_stalled( void)
+{
+    return stalled;
+}
+
+/**
+ * Wait for the device to arm the next buffer descriptor of an endpoint
+ */
+static volatile BDT_ENTRY *hostNext( uint8_t ep, uint8_t dir)
+{
+    volatile BDT_ENTRY *bd = &bdt[ ep][ dir][ host_odd[ ep][ dir]];
+    uint32_t polls = 0;
+
+    while( !bd->STAT.UOWN) {
+        if (++polls > POLLS_MAX) return NULL;
+        sim_device_poll();
+    }
+    if (bd->STAT.BSTALL) return NULL;
+    host_odd[ ep][ dir] ^= 1;
+    sim_ns += SIM_T_PACKET;
+    return bd;
+}
+
+/**
+ * Host OUT transaction
+ * @return  false if the device did not accept the packet (STALL or timeout)
+ */
+bool sim_usb_out( uint8_t ep, const uint8_t *data, uint8_t len)
+{
+    volatile BDT_ENTRY *bd = hostNext( ep, OUT_FROM_HOST);
+    uint8_t odd = host_odd[ ep][ OUT_FROM_HOST] ^ 1;
+
+    if ((bd == NULL) || (len > bd->CNT)) return false;
+    memcpy( bdt_data[ ep][ OUT_FROM_HOST][ odd], data, len);
+    bd->CNT = len;
+    bd->STAT.Val = 0;               // back to the CPU
+    return true;
+}
+
+/**
+ * Host IN transaction
+ * @return  number of bytes received, -1 if none (STALL or timeout)
+ */
+int sim_usb_in( uint8_t ep, uint8_t *data)
+{
+    volatile BDT_ENTRY *bd = hostNext( ep, IN_TO_HOST);
+    uint8_t odd = host_odd[ ep][ IN_TO_HOST] ^ 1;
+
+    if (bd == NULL) return -1;
+    memcpy( data, bdt_data[ ep][ IN_TO_HOST][ odd], bd->CNT);
+    bd->STAT.Val = 0;
+    return bd->CNT;
+}
@@ -0,0 +1,74 @@
+/*******************************************************************************
+ XPRESS-Loader host simulation: special function registers
+
+ Replaces the XC8 <xc.h> so that the firmware sources compile unchanged with
+ a host compiler. The registers are plain variables, except where the
+ simulation needs to see the firmware act on them:
+ - NOP() completes a flash read/write/erase started with PMCON1bits.RD/WR
+   (memory.c follows each of them with two NOPs, as the datasheet requires)
+ - TMR0 is derived from the simulated time, its overflows since the previous
+   read are passed to STATS_InterruptHandler() on each read
+ - LATA/LATC accesses are sampled, so that the ICSP pins can be decoded
+ ******************************************************************************/
+#ifndef SIM_XC_H
+#define SIM_XC_H
+
+#include <stdint.h>
+
+#define __XC8           1
+#define _PIC14E         1
+#define interrupt
+#define asm(x)
+#define ___mkstr(x)     #x
+#define CLRWDT()
+
+void sim_nop( void);
+void sim_delay_us( uint32_t us);
+uint8_t sim_tmr0( void);
+
+#define NOP()           sim_nop()
+#define __delay_us(x)   sim_delay_us( x)
+#define __delay_ms(x)   sim_delay_us( (uint32_t)(x) * 1000)
+
+// pins, each access samples the previous state (see sim_pins())
+typedef struct { unsigned LATC0:1, LATC1:1, LATC2:1, LATC3:1, LATC4:1, LATC5:1; } LATCbits_t;
+typedef struct { unsigned LATA4:1, LATA5:1; } LATAbits_t;
+volatile LATCbits_t *sim_latc( void);
+volatile LATAbits_t *sim_lata( void);
+#define LATCbits        (*sim_latc())
+#define LATAbits        (*sim_lata())
+
+typedef struct { unsigned TRISC0:1, TRISC1:1, TRISC2:1, TRISC3:1, TRISC4:1, TRISC5:1; } TRISCbits_t;
+typedef struct { unsigned TRISA4:1, TRISA5:1; } TRISAbits_t;
+typedef struct { unsigned RA4:1, RA5:1; } PORTAbits_t;
+typedef struct { unsigned RC4:1, RC5:1; } PORTCbits_t;
+extern volatile TRISCbits_t TRISCbits;
+extern volatile TRISAbits_t TRISAbits;
+extern volatile PORTAbits_t PORTAbits;
+extern volatile PORTCbits_t PORTCbits;
+
+// flash self-programming
+typedef struct { unsigned RD:1, WR:1, WREN:1, WRERR:1, FREE:1, LWLO:1, CFGS:1; } PMCON1bits_t;
+extern volatile PMCON1bits_t PMCON1bits;
+extern volatile uint8_t PMADRL, PMADRH, PMDATL, PMDATH, PMCON2;
+
+// interrupts, timers, PWM
+typedef struct { unsigned GIE:1, PEIE:1, TMR0IE:1, TMR0IF:1; } INTCONbits_t;
+typedef struct { unsigned TMR1IF:1, TMR2IF:1, RCIF:1, TXIF:1; } PIR1bits_t;
+typedef struct { unsigned TMR1IE:1, TMR2IE:1, RCIE:1, TXIE:1; } PIE1bits_t;
+typedef struct { unsigned PWM2EN:1, PWM2OE:1; } PWM2CONbits_t;
+extern volatile INTCONbits_t INTCONbits;
+extern volatile PIR1bits_t PIR1bits;
+extern volatile PIE1bits_t PIE1bits;
+extern volatile PWM2CONbits_t PWM2CONbits;
+extern volatile uint8_t OPTION_REG, PIE1, PIE2, PIR2;
+extern volatile uint8_t TMR1H, TMR1L, T1CON, T1GCON, TMR2, PR2, T2CON;
+extern volatile uint8_t PWM2CON, PWM2DCH, PWM2DCL;
+#define TMR0            sim_tmr0()
+
+// USB module
+typedef struct { unsigned SUSPND:1, RESUME:1, USBEN:1, PKTDIS:1, SE0:1, PPBRST:1; } UCONbits_t;
+extern volatile UCONbits_t UCONbits;
+extern volatile uint8_t UCON, UIE, UIR, UEIE, UEIR, UADDR, UCFG;
+
+#endif  /* SIM_XC_H */
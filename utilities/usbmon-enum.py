@@ -0,0 +1,58 @@
+#!/usr/bin/env python3
+"""Measure the enumeration of the XPRESS-Loader from a usbmon text trace.
+
+Capture the bus while plugging the board in, then run the script on the trace:
+    sudo modprobe usbmon
+    sudo cat /sys/kernel/debug/usb/usbmon/<bus>u > attach.txt   (Ctrl-C when mounted)
+    usbmon-enum.py attach.txt
+
+Times are relative to the first control transfer of the device (address 0,
+right after the port reset): SET_CONFIGURATION, the first SCSI command and the
+first READ(10) of the file system.
+"""
+
+import sys
+
+READ_10 = 0x28
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit(__doc__)
+    start = None
+    device = None
+    marks = {}
+    with open(sys.argv[1]) as f:
+        for line in f:
+            fields = line.split()
+            if len(fields) < 5 or fields[2] != 'S':
+                continue                        # submissions only
+            time_us = int(fields[1])
+            kind, bus, dev, ep = fields[3].split(':')
+            if kind[0] == 'C':                  # control
+                if dev == '000' and start is None:
+                    start = time_us
+                if start is None or (device and dev not in (device, '000')):
+                    continue
+                setup = fields[5:9]
+                if setup[:2] == ['00', '05']:   # SET_ADDRESS
+                    device = '%03d' % int(setup[2], 16)
+                elif setup[:2] == ['00', '09'] and 'config' not in marks:
+                    marks['config'] = time_us
+            elif kind == 'Bo' and dev == device and '=' in fields:
+                data = ''.join(fields[fields.index('=') + 1:])
+                if not data.startswith('55534243'):   # CBW signature
+                    continue
+                marks.setdefault('scsi', time_us)
+                if len(data) >= 32 and int(data[30:32], 16) == READ_10:
+                    marks.setdefault('read', time_us)
+    if start is None:
+        sys.exit('no enumeration found in the trace')
+    for key, label in (('config', 'SET_CONFIGURATION'), ('scsi', 'first SCSI command'),
+                       ('read', 'first READ(10)')):
+        if key in marks:
+            print('%-20s %8.1f ms' % (label, (marks[key] - start) / 1000.0))
+
+
+if __name__ == '__main__':
+    main()
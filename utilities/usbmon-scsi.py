@@ -0,0 +1,62 @@
+#!/usr/bin/env python3
+"""Count the SCSI commands the host sends to the XPRESS-Loader, from a usbmon trace.
+
+Capture the bus around one copy, then run the script on the trace:
+    sudo cat /sys/kernel/debug/usb/usbmon/<bus>u > copy.txt &
+    cp image.hex /media/XPRESS/ && sync && umount /media/XPRESS; kill %1
+    usbmon-scsi.py copy.txt [device address]
+
+Prints the commands by opcode, the CSWs with a failed status and the STALLs of
+the bulk endpoints: every failure costs the host a REQUEST_SENSE (and a clear
+halt for a STALL), so both counts should be 0 for a copy.
+"""
+
+import sys
+
+OPCODES = {
+    0x00: 'TEST_UNIT_READY', 0x03: 'REQUEST_SENSE', 0x12: 'INQUIRY',
+    0x1a: 'MODE_SENSE(6)', 0x1b: 'START_STOP_UNIT', 0x1e: 'PREVENT_ALLOW',
+    0x23: 'READ_FORMAT_CAPACITY', 0x25: 'READ_CAPACITY', 0x28: 'READ(10)',
+    0x2a: 'WRITE(10)', 0x2f: 'VERIFY(10)', 0x35: 'SYNCHRONIZE_CACHE',
+    0x5a: 'MODE_SENSE(10)',
+}
+
+
+def main():
+    if len(sys.argv) not in (2, 3):
+        sys.exit(__doc__)
+    device = '%03d' % int(sys.argv[2]) if len(sys.argv) == 3 else None
+    counts = {}
+    failed = {}
+    stalls = 0
+    last = None                                 # opcode of the command in progress
+    with open(sys.argv[1]) as f:
+        for line in f:
+            fields = line.split()
+            if len(fields) < 6:
+                continue
+            kind, bus, dev, ep = fields[3].split(':')
+            if kind not in ('Bo', 'Bi') or (device and dev != device):
+                continue
+            data = ''.join(fields[fields.index('=') + 1:]) if '=' in fields else ''
+            if fields[2] == 'S' and data.startswith('55534243'):    # CBW
+                device = dev
+                last = int(data[30:32], 16)
+                counts[last] = counts.get(last, 0) + 1
+            elif fields[2] == 'C' and fields[4] == '-32':
+                stalls += 1
+            elif fields[2] == 'C' and data.startswith('55534253') and len(data) >= 26:
+                if int(data[24:26], 16) != 0 and last is not None:      # CSW status
+                    failed[last] = failed.get(last, 0) + 1
+    if not counts:
+        sys.exit('no SCSI command found in the trace')
+    for op in sorted(counts):
+        print(('%-22s %6d %s' % (OPCODES.get(op, '0x%02x' % op), counts[op],
+                                 '(%d failed)' % failed[op] if op in failed else '')).rstrip())
+    print('%-22s %6d' % ('total', sum(counts.values())))
+    print('%-22s %6d' % ('failed', sum(failed.values())))
+    print('%-22s %6d' % ('STALL', stalls))
+
+
+if __name__ == '__main__':
+    main()
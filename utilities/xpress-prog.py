@@ -0,0 +1,154 @@
+#!/usr/bin/env python3
+"""Stream an Intel HEX image to the XPRESS-Loader over its CDC serial port.
+
+Uses the binary programming protocol described in MPLAB.X/stream.h: the port
+is opened at the programming baud rate, every non blank row is sent as a
+frame, with up to --window frames in flight, then the END frame programs the
+last rows and returns the verification result.
+
+Linux only (termios), no dependencies:
+    xpress-prog.py /dev/ttyACM0 image.hex [--window 8]
+"""
+
+import argparse
+import os
+import select
+import sys
+import termios
+import time
+
+SYNC = 0xA5
+CMD_WRITE = ord('W')
+CMD_END = ord('E')
+ACK = 0x06
+NAK = 0x15
+NAK_REASONS = {1: 'crc', 2: 'sequence', 3: 'length', 4: 'command'}
+RESULTS = {0: 'not verified', 1: 'PASS', 2: 'FAIL', 3: 'nothing programmed'}
+BAUDRATES = {600: termios.B600, 1200: termios.B1200, 2400: termios.B2400}
+
+
+def crc16(data):
+    crc = 0xffff
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+        crc &= 0xffff
+    return crc
+
+
+def read_hex(path, row_words):
+    """Return {row word address: row bytes}, blank filled"""
+    rows = {}
+    base = 0
+    with open(path) as f:
+        for n, line in enumerate(f, 1):
+            line = line.strip()
+            if not line.startswith(':'):
+                continue
+            rec = bytes.fromhex(line[1:])
+            if sum(rec) & 0xff:
+                sys.exit('%s:%d: bad checksum' % (path, n))
+            count, address, rtype = rec[0], (rec[1] << 8) | rec[2], rec[3]
+            data = rec[4:4 + count]
+            if rtype == 0:
+                for i, b in enumerate(data):
+                    byte = base + address + i
+                    word = byte >> 1
+                    row = word & ~(row_words - 1)
+                    buf = rows.setdefault(row, bytearray(b'\xff' * row_words * 2))
+                    buf[(word - row) * 2 + (byte & 1)] = b
+            elif rtype == 1:
+                break
+            elif rtype == 2:
+                base = ((data[0] << 8) | data[1]) << 4
+            elif rtype == 4:
+                base = ((data[0] << 8) | data[1]) << 16
+    return rows
+
+
+def frame(seq, cmd, address, data):
+    body = bytes([seq & 0xff, cmd, address & 0xff, address >> 8, len(data)]) + data
+    crc = crc16(body)
+    return bytes([SYNC]) + body + bytes([crc & 0xff, crc >> 8])
+
+
+def open_port(path, baud):
+    fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+    saved = termios.tcgetattr(fd)
+    attrs = termios.tcgetattr(fd)
+    attrs[0] = 0                                    # iflag
+    attrs[1] = 0                                    # oflag
+    attrs[2] = termios.CS8 | termios.CREAD | termios.CLOCAL
+    attrs[3] = 0                                    # lflag
+    attrs[4] = attrs[5] = BAUDRATES[baud]
+    attrs[6][termios.VMIN] = 0
+    attrs[6][termios.VTIME] = 0
+    termios.tcsetattr(fd, termios.TCSANOW, attrs)   # SET_LINE_CODING selects the protocol
+    termios.tcflush(fd, termios.TCIOFLUSH)
+    return fd, saved
+
+
+def stream(fd, frames, window, timeout):
+    """Send the frames, go-back-N; return the argument of the last ACK"""
+    base = sent = 0
+    result = None
+    rx = b''
+    deadline = time.monotonic() + timeout
+    while base < len(frames):
+        while sent < len(frames) and sent - base < window:
+            os.write(fd, frames[sent])
+            sent += 1
+        if not select.select([fd], [], [], 0.1)[0]:
+            if time.monotonic() > deadline:             # reply lost, resend
+                sent = base
+                deadline = time.monotonic() + timeout
+            continue
+        rx += os.read(fd, 64)
+        while len(rx) >= 4:
+            code, seq, arg = rx[0], rx[1], rx[2]        # rx[3] reserved
+            rx = rx[4:]
+            index = base + ((seq - base) & 0xff)
+            if code == ACK and index < sent:
+                base = index + 1
+                result = arg
+            elif code == NAK and index <= sent:
+                print('NAK %s at frame %d' % (NAK_REASONS.get(arg, arg), index), file=sys.stderr)
+                base = sent = index
+            deadline = time.monotonic() + timeout
+    return result
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('port', help='CDC serial port, e.g. /dev/ttyACM0')
+    parser.add_argument('hexfile')
+    parser.add_argument('--window', type=int, default=8, help='frames in flight (1..127)')
+    parser.add_argument('--row-words', type=int, default=32, help='words per frame')
+    parser.add_argument('--baud', type=int, default=600, choices=sorted(BAUDRATES),
+                        help='CDC_PROG_BAUDRATE of the loader')
+    parser.add_argument('--timeout', type=float, default=2.0, help='seconds without reply')
+    args = parser.parse_args()
+
+    rows = read_hex(args.hexfile, args.row_words)
+    if any(a > 0xffff for a in rows):
+        sys.exit('%s: addresses beyond the 16-bit word range' % args.hexfile)
+    frames = [frame(i, CMD_WRITE, a, bytes(rows[a])) for i, a in enumerate(sorted(rows))]
+    frames.append(frame(len(frames), CMD_END, 0, b''))
+    size = sum(len(r) for r in rows.values())
+
+    fd, saved = open_port(args.port, args.baud)
+    try:
+        start = time.monotonic()
+        result = stream(fd, frames, max(1, min(args.window, 127)), args.timeout)
+        elapsed = time.monotonic() - start
+    finally:
+        termios.tcsetattr(fd, termios.TCSADRAIN, saved)     # back to the serial bridge
+        os.close(fd)
+    print('%d rows, %d bytes in %.2fs, %.1f KB/s, %s' %
+          (len(rows), size, elapsed, size / 1024.0 / elapsed, RESULTS.get(result, result)))
+    return 0 if result in (0, 1) else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())